@@ -23,6 +23,47 @@
 // CVEC_FREE:    Replacement for free from <stdlib.h>
 // CVEC_OOBH:    Out-of-bounds handler (gets __func__, vector data address and index of overflow)
 // CVEC_OOBVAL:  Default value to return on out of bounds access
+// CVEC_COW:     Make the buffer reference-counted if defined: cvec_x_share gives an O(1) copy of
+//               the vector, mutating functions copy the buffer first if it is shared
+// CVEC_ATOMIC_ADD:  Replacement for __atomic_add_fetch (gets pointer and value, returns new value)
+// CVEC_ATOMIC_SUB:  Replacement for __atomic_sub_fetch (gets pointer and value, returns new value)
+// CVEC_ATOMIC_LOAD: Replacement for __atomic_load_n (gets pointer, returns value)
+// CVEC_SHRINK:  Shrink the buffer automatically when elements are removed if defined
+// CVEC_SHRINK_THRESHOLD: Shrink when size gets less than capacity / CVEC_SHRINK_THRESHOLD
+// CVEC_SHRINK_FACTOR:    Divide capacity by CVEC_SHRINK_FACTOR each shrink (should be <= the
+//                        threshold, otherwise the next push_back grows the buffer back)
+// CVEC_SHRINK_MIN:       Never shrink capacity below CVEC_SHRINK_MIN automatically
+// CVEC_BUDGET:  Account bytes held by the vector in the process-wide memory budget if defined,
+//               trim unused capacity when elements are removed while the budget is exceeded
+//               (down to CVEC_SHRINK_FACTOR * size once size drops to capacity /
+//               CVEC_SHRINK_THRESHOLD)
+// CVEC_INCREMENTAL: Don't copy the whole buffer on expansion if defined: allocate a new buffer
+//                   and move elements into it by portions on each subsequent push_back, pop_back
+//                   and set (like incremental rehashing), can't be used with CVEC_COW. It only
+//                   helps if CVEC_REALLOC copies on expansion: glibc's realloc moves big blocks by
+//                   mremap without copying, so a regular vector has no copy spikes with it
+// CVEC_INCREMENTAL_MIN:  Minimal size in bytes of the data to be moved incrementally
+// CVEC_INCREMENTAL_STEP: Minimal count of elements moved by each operation
+// CVEC_DISCARD:          Gives memory pages back to the system keeping them allocated (gets page-
+//                        aligned address and size), madvise(MADV_DONTNEED) on Linux by default
+// CVEC_DISCARD_CHUNK:    Count of bytes moved from the old buffer to give them back at once (should
+//                        be a power of 2 multiple of the page size)
+// CVEC_CACHE:   Recycle buffers through the per-thread cache of freed buffers if defined
+// CVEC_CACHE_MIN_SHIFT: Log2 of the smallest buffer size class in bytes
+// CVEC_CACHE_MAX_SHIFT: Log2 of the biggest buffer size class in bytes, bigger ones aren't cached
+// CVEC_CACHE_DEPTH:     Maximal count of cached buffers of a size class in a thread
+// CVEC_CACHE_BYTES:     Maximal count of bytes cached by a thread
+// CVEC_THREAD_LOCAL:    Replacement for _Thread_local
+// CVEC_PREFETCH:          Replacement for __builtin_prefetch (gets address and 1 if it's written)
+// CVEC_PREFETCH_DISTANCE: Count of elements gather, scatter and permute prefetch ahead
+// CVEC_COMPACT: Store size and capacity as 32-bit integers if defined, so the header takes 8 bytes
+//               instead of 16, can't be used with CVEC_INCREMENTAL
+// CVEC_NUMA:    Map big buffers separately with the process-wide NUMA policy set before their
+//               first touch and add parallel first-touch functions (resize_parallel,
+//               assign_fill_parallel) if defined
+// CVEC_NUMA_MIN: Minimal size in bytes of a buffer mapped separately
+// CVEC_GLOBAL_INST: Instantiate the process-wide state (memory budget, buffer cache, NUMA policy) if defined,
+//                   should be defined in exactly one translation unit of the program
 //
 // Minimal definitions for declaration: CVEC_TYPE
 // Minimal definitions for instantiation: CVEC_TYPE, CVEC_INST, CVEC_OOBVAL if the type object
@@ -30,11 +71,37 @@
 //
 // WARNING: All used definitions will be undefined on header exit.
 //
+// WARNING: With CVEC_COW writes by [] or by pointers obtained before a cvec_x_share call modify
+// every vector sharing the buffer. Use cvec_x_set, or get a fresh pointer by cvec_x_data,
+// cvec_x_begin, cvec_x_end, cvec_x_front_p or cvec_x_back_p (these detach the vector) before.
+//
+// WARNING: With CVEC_INCREMENTAL elements may be placed in two buffers after an expansion, so []
+// is only valid on pointers obtained by cvec_x_data, cvec_x_begin, cvec_x_end, cvec_x_front_p or
+// cvec_x_back_p (these finish moving of the elements) until the next expansion. Use cvec_x_at and
+// cvec_x_set to access the elements without moving them all at once.
+//
+// WARNING: With CVEC_CACHE buffers are allocated by whole size classes, so capacity may be bigger
+// than requested. Buffers cached by a thread are freed when the thread exits if pthreads are
+// available, call cvec_cache_flush before otherwise. All the CVEC_CACHE instantiations and the CVEC_GLOBAL_INST one should use
+// compatible allocators, a buffer freed by any thread is put into its own cache.
+//
+// WARNING: With CVEC_COMPACT the data is only aligned by 8 bytes and the vector can't hold more
+// than UINT32_MAX elements.
+//
 // Dependencies:
 // <stddef.h> or another source of size_t and ptrdiff_t
 // <stdint.h> or another source of SIZE_MAX
 // <stdlib.h> or another source of malloc, calloc and realloc
 // <assert.h> or another source of assert
+// <immintrin.h> if __AVX2__ is defined
+// <sys/mman.h> on Linux for the default CVEC_DISCARD (with _DEFAULT_SOURCE or _GNU_SOURCE,
+// otherwise the old buffer of CVEC_INCREMENTAL vectors is given back at once when it's released)
+// <pthread.h> on Unix-like systems for the buffer cache to be freed on thread exit
+// <pthread.h> if CVEC_NUMA is defined (with _GNU_SOURCE on Linux, otherwise the threads setting
+// parts of the vector are not pinned to CPUs)
+// <unistd.h>, <sys/mman.h> and <sys/syscall.h> on Linux for the NUMA policy (with _DEFAULT_SOURCE
+// or _GNU_SOURCE, otherwise the policy can't be set and big buffers are allocated by CVEC_MALLOC,
+// with _GNU_SOURCE big buffers are grown by mremap instead of copying)
 
 //
 // Input macros
@@ -60,6 +127,398 @@
 #endif
 #ifndef CVEC_OOBVAL
 #   define CVEC_OOBVAL { 0 }
+#endif
+#ifndef CVEC_ATOMIC_ADD
+#   define CVEC_ATOMIC_ADD(ptr, val) __atomic_add_fetch(ptr, val, __ATOMIC_ACQ_REL)
+#endif
+#ifndef CVEC_ATOMIC_SUB
+#   define CVEC_ATOMIC_SUB(ptr, val) __atomic_sub_fetch(ptr, val, __ATOMIC_ACQ_REL)
+#endif
+#ifndef CVEC_ATOMIC_LOAD
+#   define CVEC_ATOMIC_LOAD(ptr) __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#endif
+#ifndef CVEC_SHRINK_THRESHOLD
+#   define CVEC_SHRINK_THRESHOLD 4
+#endif
+#ifndef CVEC_SHRINK_FACTOR
+#   define CVEC_SHRINK_FACTOR 2
+#endif
+#ifndef CVEC_SHRINK_MIN
+#   define CVEC_SHRINK_MIN 16
+#endif
+#ifndef CVEC_INCREMENTAL_MIN
+#   define CVEC_INCREMENTAL_MIN (1 << 20)
+#endif
+#ifndef CVEC_INCREMENTAL_STEP
+#   define CVEC_INCREMENTAL_STEP 16
+#endif
+#ifndef CVEC_DISCARD_CHUNK
+#   define CVEC_DISCARD_CHUNK (1 << 16)
+#endif
+#ifndef CVEC_CACHE_MIN_SHIFT
+#   define CVEC_CACHE_MIN_SHIFT 5
+#endif
+#ifndef CVEC_CACHE_MAX_SHIFT
+#   define CVEC_CACHE_MAX_SHIFT 16
+#endif
+#ifndef CVEC_CACHE_DEPTH
+#   define CVEC_CACHE_DEPTH 16
+#endif
+#ifndef CVEC_CACHE_BYTES
+#   define CVEC_CACHE_BYTES (1 << 20)
+#endif
+#ifndef CVEC_THREAD_LOCAL
+#   define CVEC_THREAD_LOCAL _Thread_local
+#endif
+#ifndef CVEC_PREFETCH
+#   define CVEC_PREFETCH(ptr, rw) __builtin_prefetch(ptr, rw)
+#endif
+#ifndef CVEC_PREFETCH_DISTANCE
+#   define CVEC_PREFETCH_DISTANCE 32
+#endif
+#ifndef CVEC_NUMA_MIN
+#   define CVEC_NUMA_MIN (1 << 21)
+#endif
+
+//
+// Process-wide declarations
+//
+
+#ifndef CVEC_GLOBAL_DECLARED
+#define CVEC_GLOBAL_DECLARED
+
+/// Sets the limit of bytes held by all CVEC_BUDGET vectors, 0 means no limit.
+void cvec_budget_set_limit(size_t limit);
+
+/// Gets the limit of bytes held by all CVEC_BUDGET vectors.
+size_t cvec_budget_limit(void);
+
+/// Gets count of bytes currently held by all CVEC_BUDGET vectors.
+size_t cvec_budget_used(void);
+
+/// Returns non-zero if the bytes held by all CVEC_BUDGET vectors exceed the limit.
+int cvec_budget_exceeded(void);
+
+/// Sets function called when a CVEC_BUDGET vector grows beyond the limit (may be NULL). The
+/// handler may shrink long-lived vectors using shrink_to_fit.
+void cvec_budget_set_handler(void (*handler)(size_t used, size_t limit));
+
+/// Accounts bytes allocated by a CVEC_BUDGET vector, calls the handler if grown beyond the limit.
+void cvec_budget_add(size_t bytes, int grown);
+
+/// Accounts bytes released by a CVEC_BUDGET vector.
+void cvec_budget_sub(size_t bytes);
+
+/// Statistics of the calling thread's buffer cache.
+struct cvec_cache_stats {
+    size_t hits; // Buffers taken from the cache
+    size_t misses; // Buffers requested but not found in the cache
+    size_t puts; // Buffers put into the cache
+    size_t evictions; // Buffers freed since the cache was full
+    size_t bytes; // Bytes held by the cache now
+};
+
+/// Takes a buffer of (1 << shift) bytes from the calling thread's cache, NULL if there's no one.
+void *cvec_cache_take(unsigned shift);
+
+/// Puts a buffer of (1 << shift) bytes into the calling thread's cache, returns 0 if it's full.
+int cvec_cache_put(void *buf, unsigned shift);
+
+/// Frees all the buffers cached by the calling thread.
+void cvec_cache_flush(void);
+
+/// Gets statistics of the calling thread's buffer cache.
+void cvec_cache_get_stats(struct cvec_cache_stats *stats);
+
+/// NUMA policies of CVEC_NUMA vectors' big buffers.
+enum cvec_numa_policy {
+    CVEC_NUMA_DEFAULT, // Keep the policy of the thread allocating the buffer
+    CVEC_NUMA_LOCAL, // Place each page on the node of the thread touching it first
+    CVEC_NUMA_INTERLEAVE, // Spread pages over the nodes round-robin
+    CVEC_NUMA_BIND, // Place pages on the nodes only
+};
+
+/// Sets the policy of buffers allocated after the call and its nodes (bit i for node i, ignored by
+/// CVEC_NUMA_DEFAULT and CVEC_NUMA_LOCAL). Returns 0 on success, -1 if the system doesn't support
+/// the policy or the nodes, the policy is left unchanged then and vectors keep working.
+int cvec_numa_set_policy(enum cvec_numa_policy policy, unsigned long nodes);
+
+/// Gets the current NUMA policy.
+enum cvec_numa_policy cvec_numa_policy(void);
+
+/// Applies the current NUMA policy to the whole pages of the memory range, returns 0 on success.
+/// The policy stays with the pages after they are freed, so the range should be mapped separately.
+int cvec_numa_apply(void *ptr, size_t bytes);
+
+/// Maps a buffer of its own applying the current NUMA policy before its pages are touched, returns
+/// NULL if out of memory. The buffer is allocated by CVEC_MALLOC if it can't be mapped.
+void *cvec_numa_map(size_t bytes);
+
+/// Resizes a buffer given by cvec_numa_map keeping its contents, returns NULL if out of memory.
+void *cvec_numa_remap(void *ptr, size_t old_bytes, size_t bytes);
+
+/// Gives a buffer got by cvec_numa_map back to the system along with its NUMA policy.
+void cvec_numa_unmap(void *ptr, size_t bytes);
+
+/// Gets count of online CPUs (1 if it's unknown).
+unsigned cvec_numa_cpus(void);
+
+#endif
+
+#if defined(CVEC_GLOBAL_INST) && !defined(CVEC_GLOBAL_INSTANTIATED)
+#define CVEC_GLOBAL_INSTANTIATED
+
+static size_t cvec_budget_limit_bytes;
+static size_t cvec_budget_used_bytes;
+static void (*cvec_budget_handler)(size_t used, size_t limit);
+
+void cvec_budget_set_limit(size_t limit) {
+    cvec_budget_limit_bytes = limit;
+}
+
+size_t cvec_budget_limit(void) {
+    return cvec_budget_limit_bytes;
+}
+
+size_t cvec_budget_used(void) {
+    return CVEC_ATOMIC_LOAD(&cvec_budget_used_bytes);
+}
+
+int cvec_budget_exceeded(void) {
+    return cvec_budget_limit_bytes && cvec_budget_used() > cvec_budget_limit_bytes;
+}
+
+void cvec_budget_set_handler(void (*handler)(size_t used, size_t limit)) {
+    cvec_budget_handler = handler;
+}
+
+void cvec_budget_add(size_t bytes, int grown) {
+    const size_t used = CVEC_ATOMIC_ADD(&cvec_budget_used_bytes, bytes);
+    if (grown && cvec_budget_handler && cvec_budget_limit_bytes && used > cvec_budget_limit_bytes) {
+        cvec_budget_handler(used, cvec_budget_limit_bytes);
+    }
+}
+
+void cvec_budget_sub(size_t bytes) {
+    CVEC_ATOMIC_SUB(&cvec_budget_used_bytes, bytes);
+}
+
+// Cached buffers of each size class are linked through their first bytes
+static CVEC_THREAD_LOCAL void *cvec_cache_heads[CVEC_CACHE_MAX_SHIFT + 1];
+static CVEC_THREAD_LOCAL size_t cvec_cache_counts[CVEC_CACHE_MAX_SHIFT + 1];
+static CVEC_THREAD_LOCAL struct cvec_cache_stats cvec_cache_stat;
+
+#if defined(__unix__) || defined(__APPLE__)
+#   include <pthread.h>
+#   define CVEC_CACHE_AT_EXIT
+#endif
+
+#ifdef CVEC_CACHE_AT_EXIT
+// The key's destructor frees the buffers of each thread which has put anything into its cache
+static pthread_key_t cvec_cache_key;
+static pthread_once_t cvec_cache_key_once = PTHREAD_ONCE_INIT;
+static CVEC_THREAD_LOCAL int cvec_cache_registered;
+
+static void cvec_cache_at_exit(void *unused) {
+    (void)unused;
+    cvec_cache_flush();
+}
+
+static void cvec_cache_create_key(void) {
+    pthread_key_create(&cvec_cache_key, cvec_cache_at_exit);
+}
+#endif
+
+void *cvec_cache_take(unsigned shift) {
+    if (shift > CVEC_CACHE_MAX_SHIFT || !cvec_cache_heads[shift]) {
+        cvec_cache_stat.misses++;
+        return NULL;
+    }
+    void *buf = cvec_cache_heads[shift];
+    cvec_cache_heads[shift] = *(void **)buf;
+    cvec_cache_counts[shift]--;
+    cvec_cache_stat.bytes -= (size_t)1 << shift;
+    cvec_cache_stat.hits++;
+    return buf;
+}
+
+int cvec_cache_put(void *buf, unsigned shift) {
+    if (shift > CVEC_CACHE_MAX_SHIFT || cvec_cache_counts[shift] >= CVEC_CACHE_DEPTH
+        || cvec_cache_stat.bytes + ((size_t)1 << shift) > CVEC_CACHE_BYTES) {
+        cvec_cache_stat.evictions++;
+        return 0;
+    }
+#ifdef CVEC_CACHE_AT_EXIT
+    if (!cvec_cache_registered) {
+        // The destructor is only called for threads having a non-NULL value of the key
+        pthread_once(&cvec_cache_key_once, cvec_cache_create_key);
+        pthread_setspecific(cvec_cache_key, &cvec_cache_registered);
+        cvec_cache_registered = 1;
+    }
+#endif
+    *(void **)buf = cvec_cache_heads[shift];
+    cvec_cache_heads[shift] = buf;
+    cvec_cache_counts[shift]++;
+    cvec_cache_stat.bytes += (size_t)1 << shift;
+    cvec_cache_stat.puts++;
+    return 1;
+}
+
+void cvec_cache_flush(void) {
+    for (unsigned shift = 0; shift <= CVEC_CACHE_MAX_SHIFT; shift++) {
+        while (cvec_cache_heads[shift]) {
+            void *buf = cvec_cache_heads[shift];
+            cvec_cache_heads[shift] = *(void **)buf;
+            CVEC_FREE(buf);
+        }
+        cvec_cache_counts[shift] = 0;
+    }
+    cvec_cache_stat.bytes = 0;
+}
+
+void cvec_cache_get_stats(struct cvec_cache_stats *stats) {
+    *stats = cvec_cache_stat;
+}
+
+#ifdef __linux__
+#   include <unistd.h>
+#   include <sys/mman.h>
+#   include <sys/syscall.h>
+#endif
+
+// The policy is set by mbind system call directly, so libnuma is not needed
+#if defined(__linux__) && defined(SYS_mbind) && defined(MAP_ANONYMOUS)
+#   define CVEC_NUMA_SUPPORTED
+#endif
+
+static enum cvec_numa_policy cvec_numa_mode;
+static unsigned long cvec_numa_nodes;
+
+#ifdef CVEC_NUMA_SUPPORTED
+/// Sets the policy of the page-aligned memory range, returns 0 on success.
+static int cvec_numa_mbind(void *ptr, size_t bytes, enum cvec_numa_policy policy, unsigned long nodes) {
+    // MPOL_DEFAULT, MPOL_PREFERRED (with no nodes it means local), MPOL_INTERLEAVE and MPOL_BIND
+    static const int modes[] = { 0, 1, 3, 2 };
+    const int local = policy == CVEC_NUMA_LOCAL;
+    const long result = syscall(SYS_mbind, ptr, bytes, modes[policy], local ? NULL : &nodes,
+                                local ? 0 : sizeof(nodes) * 8 + 1, 0);
+    return result == 0 ? 0 : -1;
+}
+#endif
+
+int cvec_numa_set_policy(enum cvec_numa_policy policy, unsigned long nodes) {
+    if (policy != CVEC_NUMA_DEFAULT) {
+#ifdef CVEC_NUMA_SUPPORTED
+        // Check the policy on a page of its own, so that it's never rejected on a real buffer
+        const size_t page = sysconf(_SC_PAGESIZE);
+        void *probe = mmap(NULL, page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (probe == MAP_FAILED) {
+            return -1;
+        }
+        const int result = cvec_numa_mbind(probe, page, policy, nodes);
+        munmap(probe, page);
+        if (result != 0) {
+            return -1;
+        }
+#else
+        return -1;
+#endif
+    }
+    cvec_numa_mode = policy;
+    cvec_numa_nodes = nodes;
+    return 0;
+}
+
+enum cvec_numa_policy cvec_numa_policy(void) {
+    return cvec_numa_mode;
+}
+
+int cvec_numa_apply(void *ptr, size_t bytes) {
+    if (cvec_numa_mode == CVEC_NUMA_DEFAULT) {
+        return 0;
+    }
+#ifdef CVEC_NUMA_SUPPORTED
+    const uintptr_t page = sysconf(_SC_PAGESIZE);
+    const uintptr_t first = ((uintptr_t)ptr + page - 1) & ~(page - 1);
+    const uintptr_t last = ((uintptr_t)ptr + bytes) & ~(page - 1);
+    if (last <= first) {
+        return 0;
+    }
+    return cvec_numa_mbind((void *)first, last - first, cvec_numa_mode, cvec_numa_nodes);
+#else
+    (void)ptr;
+    (void)bytes;
+    return -1;
+#endif
+}
+
+#ifdef CVEC_NUMA_SUPPORTED
+/// Applies the current NUMA policy to the whole mapping, the last page too (otherwise mbind splits
+/// the mapping in two, and mremap can't move it then).
+static void cvec_numa_apply_mapping(void *ptr, size_t bytes) {
+    const size_t page = sysconf(_SC_PAGESIZE);
+    cvec_numa_apply(ptr, (bytes + page - 1) & ~(page - 1));
+}
+#endif
+
+void *cvec_numa_map(size_t bytes) {
+#ifdef CVEC_NUMA_SUPPORTED
+    void *ptr = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ptr == MAP_FAILED) {
+        return NULL;
+    }
+    cvec_numa_apply_mapping(ptr, bytes);
+    return ptr;
+#else
+    return CVEC_MALLOC(bytes);
+#endif
+}
+
+void *cvec_numa_remap(void *ptr, size_t old_bytes, size_t bytes) {
+#if defined(CVEC_NUMA_SUPPORTED) && defined(MREMAP_MAYMOVE)
+    void *new_ptr = mremap(ptr, old_bytes, bytes, MREMAP_MAYMOVE);
+    if (new_ptr == MAP_FAILED) {
+        return NULL;
+    }
+    // The mapping keeps its policy, but it may have been changed since the buffer was mapped
+    cvec_numa_apply_mapping(new_ptr, bytes);
+    return new_ptr;
+#elif defined(CVEC_NUMA_SUPPORTED)
+    char *new_ptr = cvec_numa_map(bytes);
+    if (new_ptr) {
+        for (size_t i = 0; i < old_bytes && i < bytes; i++) {
+            new_ptr[i] = ((char *)ptr)[i];
+        }
+        cvec_numa_unmap(ptr, old_bytes);
+    }
+    return new_ptr;
+#else
+    (void)old_bytes;
+    return CVEC_REALLOC(ptr, bytes);
+#endif
+}
+
+void cvec_numa_unmap(void *ptr, size_t bytes) {
+#ifdef CVEC_NUMA_SUPPORTED
+    munmap(ptr, bytes);
+#else
+    (void)bytes;
+    CVEC_FREE(ptr);
+#endif
+}
+
+unsigned cvec_numa_cpus(void) {
+#ifdef __linux__
+    const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    return cpus > 0 ? (unsigned)cpus : 1;
+#else
+    return 1;
+#endif
+}
+
+#undef CVEC_NUMA_SUPPORTED
+#undef CVEC_CACHE_AT_EXIT
+
 #endif
 
 //
@@ -72,6 +531,74 @@
 /// Creates method name according to CVEC_TYPE
 #define CVEC_FUN(name) CVEC_CONCAT2(CVEC_TYPE, name)
 
+/// Type of the header slots and the biggest count of elements it can hold
+#ifdef CVEC_COMPACT
+#   define CVEC_HDR_T uint32_t
+#   define CVEC_SIZE_MAX UINT32_MAX
+#else
+#   define CVEC_HDR_T size_t
+#   define CVEC_SIZE_MAX SIZE_MAX
+#endif
+
+/// Count of CVEC_HDR_T slots placed before the vector's data: [..., size, capacity]
+/// Copy-on-write vectors also store the reference counter at [-3]. Incremental vectors store the
+/// old buffer at [-3], count of moved elements at [-4] and count of elements to move at [-5]. The
+/// header is padded to keep the data aligned by 2 * sizeof(CVEC_HDR_T) anyway.
+#if defined(CVEC_COW) && defined(CVEC_INCREMENTAL)
+#   error "CVEC_COW and CVEC_INCREMENTAL can't be used together"
+#endif
+#if defined(CVEC_COMPACT) && defined(CVEC_INCREMENTAL)
+#   error "CVEC_COMPACT and CVEC_INCREMENTAL can't be used together"
+#endif
+#if defined(CVEC_INCREMENTAL)
+#   define CVEC_HDR_LEN 6
+#elif defined(CVEC_COW)
+#   define CVEC_HDR_LEN 4
+#else
+#   define CVEC_HDR_LEN 2
+#endif
+
+/// Gets the beginning of the allocated buffer by the vector
+#define CVEC_HDR(vec) (&((CVEC_HDR_T *)*(vec))[-CVEC_HDR_LEN])
+
+/// Gets size of the buffer holding <count> elements
+#define CVEC_BUF_SIZE(count) ((count) * sizeof(CVEC_TYPE) + sizeof(CVEC_HDR_T) * CVEC_HDR_LEN)
+
+/// Makes the vector the only owner of its buffer keeping <keep> first elements
+#ifdef CVEC_COW
+#   define CVEC_DETACH(vec, keep) cvec_x_detach(vec, keep)
+#else
+#   define CVEC_DETACH(vec, keep)
+#endif
+
+/// Gets element of the vector wherever it is placed
+#ifdef CVEC_INCREMENTAL
+#   define CVEC_ELEM(vec, i) (*cvec_x_elem(vec, i))
+#else
+#   define CVEC_ELEM(vec, i) ((*(vec))[i])
+#endif
+
+/// Moves all the elements of the vector into its current buffer
+#ifdef CVEC_INCREMENTAL
+#   define CVEC_SETTLE(vec) cvec_x_migrate(vec, SIZE_MAX)
+#else
+#   define CVEC_SETTLE(vec)
+#endif
+
+/// Checks if the buffer of <bytes> is mapped separately by cvec_numa_map instead of CVEC_MALLOC
+#ifdef CVEC_NUMA
+#   define CVEC_MAPPED(bytes) ((bytes) >= CVEC_NUMA_MIN)
+#else
+#   define CVEC_MAPPED(bytes) ((void)(bytes), 0)
+#endif
+
+/// Applies the shrink policy to the vector after its elements were removed
+#if defined(CVEC_SHRINK) || defined(CVEC_BUDGET)
+#   define CVEC_AUTO_SHRINK(vec) cvec_x_auto_shrink(vec)
+#else
+#   define CVEC_AUTO_SHRINK(vec)
+#endif
+
 #define cvec_x_new CVEC_FUN(new)
 #define cvec_x_capacity CVEC_FUN(capacity)
 #define cvec_x_size CVEC_FUN(size)
@@ -85,6 +612,7 @@
 #define cvec_x_end CVEC_FUN(end)
 #define cvec_x_cend CVEC_FUN(cend)
 #define cvec_x_push_back CVEC_FUN(push_back)
+#define cvec_x_extend CVEC_FUN(extend)
 #define cvec_x_at CVEC_FUN(at)
 #define cvec_x_reserve CVEC_FUN(reserve)
 #define cvec_x_shrink_to_fit CVEC_FUN(shrink_to_fit)
@@ -102,16 +630,44 @@
 #define cvec_x_max_size CVEC_FUN(max_size)
 #define cvec_x_insert CVEC_FUN(insert)
 #define cvec_x_insert_it CVEC_FUN(insert_it)
+#define cvec_x_set CVEC_FUN(set)
+#define cvec_x_gather CVEC_FUN(gather)
+#define cvec_x_scatter CVEC_FUN(scatter)
+#define cvec_x_permute CVEC_FUN(permute)
+#define cvec_x_apply_permutation CVEC_FUN(apply_permutation)
+#define cvec_x_share CVEC_FUN(share)
+#define cvec_x_use_count CVEC_FUN(use_count)
+#define cvec_x_migrate CVEC_FUN(migrate)
+#define cvec_x_resize_parallel CVEC_FUN(resize_parallel)
+#define cvec_x_assign_fill_parallel CVEC_FUN(assign_fill_parallel)
 
 #define cvec_x_grow CVEC_FUN(grow)
 #define cvec_x_set_capacity CVEC_FUN(set_capacity)
 #define cvec_x_set_size CVEC_FUN(set_size)
+#define cvec_x_refcount CVEC_FUN(refcount)
+#define cvec_x_detach CVEC_FUN(detach)
+#define cvec_x_unshare CVEC_FUN(unshare)
+#define cvec_x_auto_shrink CVEC_FUN(auto_shrink)
+#define cvec_x_old CVEC_FUN(old)
+#define cvec_x_migrated CVEC_FUN(migrated)
+#define cvec_x_old_count CVEC_FUN(old_count)
+#define cvec_x_elem CVEC_FUN(elem)
+#define cvec_x_migrate_step CVEC_FUN(migrate_step)
+#define cvec_x_truncate_old CVEC_FUN(truncate_old)
+#define cvec_x_alloc CVEC_FUN(alloc)
+#define cvec_x_release CVEC_FUN(release)
+#define cvec_x_move CVEC_FUN(move)
+#define cvec_x_size_class CVEC_FUN(size_class)
+#define cvec_x_gather_data CVEC_FUN(gather_data)
+#define cvec_x_fill_job CVEC_FUN(fill_job)
+#define cvec_x_fill_part CVEC_FUN(fill_part)
+#define cvec_x_fill_parallel CVEC_FUN(fill_parallel)
 
 //
 // External declarations
 //
 
-/// Allocates new vector of specified capacity.
+/// Allocates new vector of specified capacity, an empty vector (NULL) if it's 0.
 CVEC_TYPE *cvec_x_new(size_t count);
 
 /// Gets the current capacity of the vector.
@@ -132,7 +688,7 @@ CVEC_TYPE cvec_x_pop_back(CVEC_TYPE **vec);
 /// Removes the element at index i from the vector.
 void cvec_x_erase(CVEC_TYPE **vec, size_t i);
 
-/// Frees all memory associated with the vector.
+/// Frees all memory associated with the vector, leaves it empty (NULL).
 void cvec_x_free(CVEC_TYPE **vec);
 
 /// Returns an iterator to first element of the vector.
@@ -150,6 +706,10 @@ const CVEC_TYPE *cvec_x_cend(CVEC_TYPE **vec);
 /// Adds an element to the end of the vector.
 void cvec_x_push_back(CVEC_TYPE **vec, CVEC_TYPE value);
 
+/// Adds count uninitialized elements to the end of the vector, returns pointer to the first one.
+/// Capacity grows the same way as on push_back, so repeated bulk appends are amortized O(1).
+CVEC_TYPE *cvec_x_extend(CVEC_TYPE **vec, size_t count);
+
 /// Gets element with bounds checking. On out of bounds calls CVEC_OOBH and returns CVEC_OOBVAL.
 CVEC_TYPE cvec_x_at(CVEC_TYPE **vec, size_t i);
 
@@ -163,7 +723,7 @@ void cvec_x_shrink_to_fit(CVEC_TYPE **vec);
 void cvec_x_assign_fill(CVEC_TYPE **vec, size_t count, CVEC_TYPE value);
 
 /// Replaces the contents with data from range [first, last).
-void cvec_x_assign_range(CVEC_TYPE **vec, CVEC_TYPE *first, CVEC_TYPE *last);
+void cvec_x_assign_range(CVEC_TYPE **vec, const CVEC_TYPE *first, const CVEC_TYPE *last);
 
 /// Replaces the contents with contetns of other.
 void cvec_x_assign_other(CVEC_TYPE **vec, CVEC_TYPE **other);
@@ -201,12 +761,73 @@ CVEC_TYPE *cvec_x_insert(CVEC_TYPE **vec, size_t index, CVEC_TYPE value);
 /// Inserts a value into vector by iterator (pointer in vector).
 CVEC_TYPE *cvec_x_insert_it(CVEC_TYPE **vec, CVEC_TYPE *it, CVEC_TYPE value);
 
+/// Sets element with bounds checking. On out of bounds calls CVEC_OOBH and does nothing.
+void cvec_x_set(CVEC_TYPE **vec, size_t i, CVEC_TYPE value);
+
+/// Copies n elements of the vector at indices idx[0..n) into dst (indices should be less than
+/// size, dst should not overlap the vector).
+void cvec_x_gather(CVEC_TYPE *dst, CVEC_TYPE **vec, const size_t *idx, size_t n);
+
+/// Copies n elements of src into the vector at indices idx[0..n) (indices should be less than
+/// size, the last write wins on repeated indices).
+void cvec_x_scatter(CVEC_TYPE **vec, const CVEC_TYPE *src, const size_t *idx, size_t n);
+
+/// Reorders the vector so that element i is the one previously at perm[i] using a new buffer.
+void cvec_x_permute(CVEC_TYPE **vec, const size_t *perm);
+
+/// Reorders the vector like cvec_x_permute does but in place, following cycles of perm. Marks
+/// visited entries of perm by the top bit and restores them before returning.
+void cvec_x_apply_permutation(CVEC_TYPE **vec, size_t *perm);
+
+#ifdef CVEC_COW
+/// Returns the vector sharing the buffer with the given one, O(1).
+CVEC_TYPE *cvec_x_share(CVEC_TYPE **vec);
+
+/// Returns count of vectors sharing the buffer with the given one (0 if there's no buffer).
+size_t cvec_x_use_count(CVEC_TYPE **vec);
+#endif
+
+#ifdef CVEC_INCREMENTAL
+/// Moves up to count elements into the current buffer, returns count of elements left to move.
+size_t cvec_x_migrate(CVEC_TYPE **vec, size_t count);
+#endif
+
+#ifdef CVEC_NUMA
+/// Resizes the vector like cvec_x_resize_v, but new elements are set by <threads> threads (one per
+/// online CPU if 0), each one setting an equal contiguous part of them. The threads are pinned to
+/// the CPUs the calling thread may run on round-robin before they touch their parts, so pages
+/// placed on the first touch stay on the nodes of these CPUs, and parallel readers pinned the same
+/// way get their parts from their own NUMA nodes.
+void cvec_x_resize_parallel(CVEC_TYPE **vec, size_t count, CVEC_TYPE value, unsigned threads);
+
+/// Replaces the contents of the vector like cvec_x_assign_fill, but sets the elements by <threads>
+/// threads as cvec_x_resize_parallel does. Takes a new buffer if the current one is too small.
+void cvec_x_assign_fill_parallel(CVEC_TYPE **vec, size_t count, CVEC_TYPE value, unsigned threads);
+#endif
+
 //
 // Function definitions
 //
 
 #ifdef CVEC_INST
 
+#ifdef __AVX2__
+#   include <immintrin.h>
+#endif
+#ifdef CVEC_NUMA
+#   include <pthread.h>
+#endif
+#if defined(CVEC_INCREMENTAL) && defined(__linux__)
+#   include <sys/mman.h>
+#endif
+#ifndef CVEC_DISCARD
+#   ifdef MADV_DONTNEED
+#       define CVEC_DISCARD(ptr, size) madvise(ptr, size, MADV_DONTNEED)
+#   else
+#       define CVEC_DISCARD(ptr, size)
+#   endif
+#endif
+
 /// Ensures that the vector is at least <count> elements big.
 static void cvec_x_grow(CVEC_TYPE **vec, size_t count);
 
@@ -216,28 +837,95 @@ static void cvec_x_set_capacity(CVEC_TYPE **vec, size_t size);
 /// Sets the size variable of the vector.
 static void cvec_x_set_size(CVEC_TYPE **vec, size_t size);
 
+/// Allocates new vector of specified capacity, the budget handler is called if grown is non-zero.
+static CVEC_TYPE *cvec_x_alloc(size_t count, int grown);
+
+/// Frees the vector's buffer regardless of its references.
+static void cvec_x_release(CVEC_TYPE **vec);
+
+/// Moves the vector's elements into a new buffer of <count> elements and releases the old one.
+static void cvec_x_move(CVEC_TYPE **vec, size_t count, int grown);
+
+#ifdef CVEC_COW
+/// Gets the reference counter of the vector's buffer.
+static CVEC_HDR_T *cvec_x_refcount(CVEC_TYPE **vec);
+
+/// Copies the vector into a new buffer of <count> elements keeping <keep> first elements of it.
+static void cvec_x_unshare(CVEC_TYPE **vec, size_t count, size_t keep);
+
+/// Unshares the vector if its buffer is shared keeping the elements the caller needs (the size the
+/// vector will have, clamped to the current one), drops the reference to it if keep is 0.
+static void cvec_x_detach(CVEC_TYPE **vec, size_t keep);
+#endif
+
+#if defined(CVEC_SHRINK) || defined(CVEC_BUDGET)
+/// Shrinks the buffer according to the shrink policy and the memory budget.
+static void cvec_x_auto_shrink(CVEC_TYPE **vec);
+#endif
+
+#ifdef CVEC_INCREMENTAL
+/// Gets the old buffer elements are being moved from (NULL if there's nothing to move).
+static CVEC_TYPE **cvec_x_old(CVEC_TYPE **vec);
+
+/// Gets count of elements moved from the old buffer.
+static size_t *cvec_x_migrated(CVEC_TYPE **vec);
+
+/// Gets count of elements to move from the old buffer.
+static size_t *cvec_x_old_count(CVEC_TYPE **vec);
+
+/// Gets pointer to the element at index i in either buffer.
+static CVEC_TYPE *cvec_x_elem(CVEC_TYPE **vec, size_t i);
+
+/// Moves enough elements to finish before the current buffer is exhausted by push_back.
+static void cvec_x_migrate_step(CVEC_TYPE **vec);
+
+/// Forgets old buffer elements starting from index size, frees the old buffer if nothing's left.
+static void cvec_x_truncate_old(CVEC_TYPE **vec, size_t size);
+
+/// Gives back pages of the old buffer which became free by moving elements [from, to) out of it.
+static void cvec_x_discard_old(CVEC_TYPE *old, size_t from, size_t to);
+#endif
+
+#ifdef CVEC_CACHE
+/// Gets log2 of the smallest size class fitting the bytes (> CVEC_CACHE_MAX_SHIFT if none).
+static unsigned cvec_x_size_class(size_t bytes);
+#endif
+
+/// Copies src[idx[i]] into dst[i] for each i < n prefetching the elements to copy next.
+static void cvec_x_gather_data(CVEC_TYPE *dst, const CVEC_TYPE *src, const size_t *idx, size_t n);
+
+#ifdef CVEC_NUMA
+/// Part of the elements set by a thread.
+struct cvec_x_fill_job {
+    CVEC_TYPE *first;
+    size_t count;
+    CVEC_TYPE value;
+    int cpu; // CPU the thread is pinned to, -1 if it's not pinned
+};
+
+/// Sets the elements of a part, thread entry point.
+static void *cvec_x_fill_part(void *job);
+
+/// Sets count elements starting from first by the threads, each one setting a contiguous part.
+static void cvec_x_fill_parallel(CVEC_TYPE *first, size_t count, CVEC_TYPE value, unsigned threads);
+#endif
+
 //
 // Public functions
 //
 
 CVEC_TYPE *cvec_x_new(size_t count) {
-    const size_t cv_sz = count * sizeof(CVEC_TYPE) + sizeof(size_t) * 2;
-    size_t *cv_p = CVEC_MALLOC(cv_sz);
-    CVEC_ASSERT(cv_p);
-    CVEC_TYPE *vec = (void *)(&cv_p[2]);
-    cvec_x_set_capacity(&vec, count);
-    cvec_x_set_size(&vec, 0);
-    return vec;
+    return count ? cvec_x_alloc(count, 1) : NULL;
 }
 
 size_t cvec_x_capacity(CVEC_TYPE **vec) {
     CVEC_ASSERT(vec);
-    return *vec ? ((size_t *)*vec)[-1] : (size_t)0;
+    return *vec ? ((CVEC_HDR_T *)*vec)[-1] : (size_t)0;
 }
 
 size_t cvec_x_size(CVEC_TYPE **vec) {
     CVEC_ASSERT(vec);
-    return *vec ? ((size_t *)*vec)[-2] : (size_t)0;
+    return *vec ? ((CVEC_HDR_T *)*vec)[-2] : (size_t)0;
 }
 
 int cvec_x_empty(CVEC_TYPE **vec) {
@@ -248,7 +936,7 @@ CVEC_TYPE cvec_x_pop_front(CVEC_TYPE **vec) {
     CVEC_ASSERT(vec);
     CVEC_ASSERT(*vec);
     CVEC_ASSERT(cvec_x_size(vec) > 0);
-    CVEC_TYPE result = (*vec)[0];
+    CVEC_TYPE result = CVEC_ELEM(vec, 0);
     cvec_x_erase(vec, 0);
     return result;
 }
@@ -258,8 +946,15 @@ CVEC_TYPE cvec_x_pop_back(CVEC_TYPE **vec) {
     CVEC_ASSERT(*vec);
     const size_t size = cvec_x_size(vec);
     CVEC_ASSERT(size > 0);
+    CVEC_DETACH(vec, size);
+    CVEC_TYPE result = CVEC_ELEM(vec, size - 1);
     cvec_x_set_size(vec, size - 1);
-    return (*vec)[size - 1];
+#ifdef CVEC_INCREMENTAL
+    cvec_x_truncate_old(vec, size - 1);
+    cvec_x_migrate_step(vec);
+#endif
+    CVEC_AUTO_SHRINK(vec);
+    return result;
 }
 
 void cvec_x_erase(CVEC_TYPE **vec, size_t i) {
@@ -267,38 +962,59 @@ void cvec_x_erase(CVEC_TYPE **vec, size_t i) {
     if (*vec) {
         const size_t cv_sz = cvec_x_size(vec);
         if (i < cv_sz) {
+            CVEC_DETACH(vec, cv_sz);
+            CVEC_SETTLE(vec);
             cvec_x_set_size(vec, cv_sz - 1);
             for (size_t cv_x = i; cv_x < (cv_sz - 1); ++cv_x) {
                 (*vec)[cv_x] = (*vec)[cv_x + 1];
             }
+            CVEC_AUTO_SHRINK(vec);
         }
     }
 }
 
 void cvec_x_free(CVEC_TYPE **vec) {
     CVEC_ASSERT(vec);
-    if (*vec) {
-        size_t *p1 = &((size_t *)*vec)[-2];
-        CVEC_FREE(p1);
+    if (!*vec) {
+        return;
+    }
+#ifdef CVEC_COW
+    if (CVEC_ATOMIC_SUB(cvec_x_refcount(vec), 1) != 0) {
+        *vec = NULL;
+        return;
     }
+#endif
+#ifdef CVEC_INCREMENTAL
+    cvec_x_truncate_old(vec, 0);
+#endif
+    cvec_x_release(vec);
+    *vec = NULL;
 }
 
 CVEC_TYPE *cvec_x_begin(CVEC_TYPE **vec) {
     CVEC_ASSERT(vec);
+    CVEC_DETACH(vec, cvec_x_size(vec));
+    CVEC_SETTLE(vec);
     return *vec;
 }
 
 const CVEC_TYPE *cvec_x_cbegin(CVEC_TYPE **vec) {
-    return cvec_x_begin(vec);
+    CVEC_ASSERT(vec);
+    CVEC_SETTLE(vec);
+    return *vec;
 }
 
 CVEC_TYPE *cvec_x_end(CVEC_TYPE **vec) {
     CVEC_ASSERT(vec);
+    CVEC_DETACH(vec, cvec_x_size(vec));
+    CVEC_SETTLE(vec);
     return *vec ? &((*vec)[cvec_x_size(vec)]) : NULL;
 }
 
 const CVEC_TYPE *cvec_x_cend(CVEC_TYPE **vec) {
-    return cvec_x_end(vec);
+    CVEC_ASSERT(vec);
+    CVEC_SETTLE(vec);
+    return *vec ? &((*vec)[cvec_x_size(vec)]) : NULL;
 }
 
 void cvec_x_push_back(CVEC_TYPE **vec, CVEC_TYPE value) {
@@ -306,11 +1022,33 @@ void cvec_x_push_back(CVEC_TYPE **vec, CVEC_TYPE value) {
     size_t cv_cap = cvec_x_capacity(vec);
     if (cv_cap <= cvec_x_size(vec)) {
         cvec_x_grow(vec, cv_cap * CVEC_LOGG + 1);
+    } else {
+        CVEC_DETACH(vec, cvec_x_size(vec) + 1);
     }
+#ifdef CVEC_INCREMENTAL
+    cvec_x_migrate_step(vec);
+#endif
     (*vec)[cvec_x_size(vec)] = value;
     cvec_x_set_size(vec, cvec_x_size(vec) + 1);
 }
 
+CVEC_TYPE *cvec_x_extend(CVEC_TYPE **vec, size_t count) {
+    CVEC_ASSERT(vec);
+    const size_t cv_sz = cvec_x_size(vec);
+    const size_t cv_cap = cvec_x_capacity(vec);
+    if (cv_cap - cv_sz < count) {
+        const size_t cv_new_cap = cv_cap * CVEC_LOGG + 1;
+        cvec_x_grow(vec, cv_new_cap > cv_sz + count ? cv_new_cap : cv_sz + count);
+    } else {
+        CVEC_DETACH(vec, cv_sz + count);
+    }
+#ifdef CVEC_INCREMENTAL
+    cvec_x_migrate_step(vec);
+#endif
+    cvec_x_set_size(vec, cv_sz + count);
+    return *vec ? *vec + cv_sz : NULL;
+}
+
 CVEC_TYPE cvec_x_at(CVEC_TYPE **vec, size_t i) {
     CVEC_ASSERT(vec);
     if (i >= cvec_x_size(vec) || i < 0) {
@@ -318,7 +1056,7 @@ CVEC_TYPE cvec_x_at(CVEC_TYPE **vec, size_t i) {
         CVEC_TYPE ret = CVEC_OOBVAL;
         return ret;
     }
-    return (*vec)[i];
+    return CVEC_ELEM(vec, i);
 }
 
 void cvec_x_reserve(CVEC_TYPE **vec, size_t new_cap) {
@@ -336,6 +1074,11 @@ void cvec_x_shrink_to_fit(CVEC_TYPE **vec) {
 
 void cvec_x_assign_fill(CVEC_TYPE **vec, size_t count, CVEC_TYPE value) {
     CVEC_ASSERT(vec);
+    CVEC_DETACH(vec, 0);
+#ifdef CVEC_INCREMENTAL
+    cvec_x_set_size(vec, 0);
+    cvec_x_truncate_old(vec, 0);
+#endif
     cvec_x_reserve(vec, count);
     cvec_x_set_size(vec, count); // If the buffer was bigger than new_cap, set size ourselves
     for (size_t i = 0; i < count; i++) {
@@ -343,23 +1086,38 @@ void cvec_x_assign_fill(CVEC_TYPE **vec, size_t count, CVEC_TYPE value) {
     }
 }
 
-void cvec_x_assign_range(CVEC_TYPE **vec, CVEC_TYPE *first, CVEC_TYPE *last) {
+void cvec_x_assign_range(CVEC_TYPE **vec, const CVEC_TYPE *first, const CVEC_TYPE *last) {
     CVEC_ASSERT(vec);
     size_t new_size = ((ptrdiff_t)(last - first)) / sizeof(*first);
+    CVEC_DETACH(vec, 0);
+#ifdef CVEC_INCREMENTAL
+    cvec_x_set_size(vec, 0);
+    cvec_x_truncate_old(vec, 0);
+#endif
     cvec_x_reserve(vec, new_size);
     cvec_x_set_size(vec, new_size);
     size_t i = 0;
-    for (CVEC_TYPE *it = first; it < last; it++, i++) {
+    for (const CVEC_TYPE *it = first; it < last; it++, i++) {
         (*vec)[i] = *it;
     }
 }
 
 void cvec_x_assign_other(CVEC_TYPE **vec, CVEC_TYPE **other) {
-    cvec_x_assign_range(vec, cvec_x_begin(other), cvec_x_end(other));
+#ifdef CVEC_COW
+    CVEC_ASSERT(vec);
+    if (*vec != *other) {
+        cvec_x_free(vec);
+        *vec = cvec_x_share(other);
+    }
+#else
+    cvec_x_assign_range(vec, cvec_x_cbegin(other), cvec_x_cend(other));
+#endif
 }
 
 CVEC_TYPE *cvec_x_data(CVEC_TYPE **vec) {
     CVEC_ASSERT(vec);
+    CVEC_DETACH(vec, cvec_x_size(vec));
+    CVEC_SETTLE(vec);
     return (*vec);
 }
 
@@ -371,31 +1129,40 @@ void cvec_x_resize(CVEC_TYPE **vec, size_t count) {
 void cvec_x_resize_v(CVEC_TYPE **vec, size_t count, CVEC_TYPE value) {
     CVEC_ASSERT(vec);
     size_t old_size = cvec_x_size(vec);
+    CVEC_DETACH(vec, count);
+    CVEC_SETTLE(vec);
+    cvec_x_reserve(vec, count);
     cvec_x_set_size(vec, count);
-    if (cvec_x_capacity(vec) < count) {
-        cvec_x_reserve(vec, count);
-        for (CVEC_TYPE *it = (*vec) + old_size; it < cvec_x_end(vec); it++) {
-            *it = value;
-        }
+    for (CVEC_TYPE *it = (*vec) + old_size; it < (*vec) + count; it++) {
+        *it = value;
+    }
+    if (count < old_size) {
+        CVEC_AUTO_SHRINK(vec);
     }
 }
 
 void cvec_x_clear(CVEC_TYPE **vec) {
+    CVEC_DETACH(vec, 0);
     cvec_x_set_size(vec, 0);
+#ifdef CVEC_INCREMENTAL
+    cvec_x_truncate_old(vec, 0);
+#endif
+    CVEC_AUTO_SHRINK(vec);
 }
 
 CVEC_TYPE cvec_x_front(CVEC_TYPE **vec) {
     CVEC_ASSERT(vec);
-    return (*vec)[0];
+    return CVEC_ELEM(vec, 0);
 }
 
 CVEC_TYPE *cvec_x_front_p(CVEC_TYPE **vec) {
-    CVEC_ASSERT(vec);
-    return (*vec);
+    return cvec_x_begin(vec);
 }
 
 CVEC_TYPE cvec_x_back(CVEC_TYPE **vec) {
-    return cvec_x_end(vec)[-1];
+    CVEC_ASSERT(vec);
+    CVEC_ASSERT(*vec);
+    return CVEC_ELEM(vec, cvec_x_size(vec) - 1);
 }
 
 CVEC_TYPE *cvec_x_back_p(CVEC_TYPE **vec) {
@@ -403,7 +1170,8 @@ CVEC_TYPE *cvec_x_back_p(CVEC_TYPE **vec) {
 }
 
 size_t cvec_x_max_size(CVEC_TYPE **vec) {
-    return SIZE_MAX / sizeof(**vec);
+    const size_t cv_max = SIZE_MAX / sizeof(**vec);
+    return cv_max < CVEC_SIZE_MAX ? cv_max : CVEC_SIZE_MAX;
 }
 
 CVEC_TYPE *cvec_x_insert(CVEC_TYPE **vec, size_t index, CVEC_TYPE value) {
@@ -412,6 +1180,8 @@ CVEC_TYPE *cvec_x_insert(CVEC_TYPE **vec, size_t index, CVEC_TYPE value) {
         return NULL; // TODO: What?
     }
     size_t new_size = cvec_x_size(vec) + 1;
+    CVEC_DETACH(vec, new_size);
+    CVEC_SETTLE(vec);
     cvec_x_reserve(vec, new_size);
     cvec_x_set_size(vec, new_size);
     CVEC_TYPE *ret = *vec + index;
@@ -428,6 +1198,144 @@ CVEC_TYPE *cvec_x_insert_it(CVEC_TYPE **vec, CVEC_TYPE *it, CVEC_TYPE value) {
     return cvec_x_insert(vec, index, value);
 }
 
+void cvec_x_set(CVEC_TYPE **vec, size_t i, CVEC_TYPE value) {
+    CVEC_ASSERT(vec);
+    if (i >= cvec_x_size(vec)) {
+        CVEC_OOBH(__func__, vec, i);
+        return;
+    }
+    CVEC_DETACH(vec, cvec_x_size(vec));
+    CVEC_ELEM(vec, i) = value;
+#ifdef CVEC_INCREMENTAL
+    cvec_x_migrate_step(vec);
+#endif
+}
+
+void cvec_x_gather(CVEC_TYPE *dst, CVEC_TYPE **vec, const size_t *idx, size_t n) {
+    CVEC_ASSERT(vec);
+    cvec_x_gather_data(dst, cvec_x_cbegin(vec), idx, n);
+}
+
+void cvec_x_scatter(CVEC_TYPE **vec, const CVEC_TYPE *src, const size_t *idx, size_t n) {
+    CVEC_ASSERT(vec);
+    CVEC_TYPE *data = cvec_x_data(vec);
+    // There are no scatter instructions in AVX2, so just prefetch the destinations for writing
+    for (size_t i = 0; i < n; i++) {
+        if (i + CVEC_PREFETCH_DISTANCE < n) {
+            CVEC_PREFETCH(&data[idx[i + CVEC_PREFETCH_DISTANCE]], 1);
+        }
+        data[idx[i]] = src[i];
+    }
+}
+
+void cvec_x_permute(CVEC_TYPE **vec, const size_t *perm) {
+    CVEC_ASSERT(vec);
+    const size_t size = cvec_x_size(vec);
+    CVEC_TYPE *new_vec = cvec_x_new(size);
+    cvec_x_set_size(&new_vec, size);
+    cvec_x_gather_data(new_vec, cvec_x_cbegin(vec), perm, size);
+    cvec_x_free(vec);
+    *vec = new_vec;
+}
+
+void cvec_x_apply_permutation(CVEC_TYPE **vec, size_t *perm) {
+    CVEC_ASSERT(vec);
+    const size_t size = cvec_x_size(vec);
+    const size_t mark = ~(SIZE_MAX >> 1);
+    CVEC_TYPE *data = cvec_x_data(vec);
+    for (size_t i = 0; i < size; i++) {
+        if (perm[i] & mark) {
+            continue;
+        }
+        // Shift elements along the cycle starting at i, the first one goes to its end
+        CVEC_TYPE first = data[i];
+        size_t j = i;
+        for (;;) {
+            const size_t k = perm[j];
+            perm[j] |= mark;
+            if (k == i) {
+                data[j] = first;
+                break;
+            }
+            data[j] = data[k];
+            j = k;
+        }
+    }
+    for (size_t i = 0; i < size; i++) {
+        perm[i] &= ~mark;
+    }
+}
+
+#ifdef CVEC_COW
+CVEC_TYPE *cvec_x_share(CVEC_TYPE **vec) {
+    CVEC_ASSERT(vec);
+    if (*vec) {
+        CVEC_ATOMIC_ADD(cvec_x_refcount(vec), 1);
+    }
+    return *vec;
+}
+
+size_t cvec_x_use_count(CVEC_TYPE **vec) {
+    CVEC_ASSERT(vec);
+    return *vec ? CVEC_ATOMIC_LOAD(cvec_x_refcount(vec)) : (size_t)0;
+}
+#endif
+
+#ifdef CVEC_INCREMENTAL
+size_t cvec_x_migrate(CVEC_TYPE **vec, size_t count) {
+    CVEC_ASSERT(vec);
+    if (!*vec || !*cvec_x_old(vec)) {
+        return 0;
+    }
+    CVEC_TYPE *old = *cvec_x_old(vec);
+    const size_t end = *cvec_x_old_count(vec);
+    const size_t first = *cvec_x_migrated(vec);
+    size_t i = first;
+    for (; i < end && count; i++, count--) {
+        (*vec)[i] = old[i];
+    }
+    *cvec_x_migrated(vec) = i;
+    if (i < end) {
+        // Free memory of the old buffer by chunks, so that releasing it at the end is cheap too
+        cvec_x_discard_old(old, first, i);
+        return end - i;
+    }
+    cvec_x_release(&old);
+    *cvec_x_old(vec) = NULL;
+    return 0;
+}
+#endif
+
+#ifdef CVEC_NUMA
+void cvec_x_resize_parallel(CVEC_TYPE **vec, size_t count, CVEC_TYPE value, unsigned threads) {
+    CVEC_ASSERT(vec);
+    const size_t old_size = cvec_x_size(vec);
+    CVEC_DETACH(vec, count);
+    CVEC_SETTLE(vec);
+    cvec_x_reserve(vec, count);
+    cvec_x_set_size(vec, count);
+    if (count > old_size) {
+        cvec_x_fill_parallel(*vec + old_size, count - old_size, value, threads);
+    } else {
+        CVEC_AUTO_SHRINK(vec);
+    }
+}
+
+void cvec_x_assign_fill_parallel(CVEC_TYPE **vec, size_t count, CVEC_TYPE value, unsigned threads) {
+    CVEC_ASSERT(vec);
+    // Pages of the current buffer are placed already, and its contents is not needed anyway
+    if (cvec_x_capacity(vec) < count) {
+        cvec_x_free(vec);
+    }
+    CVEC_DETACH(vec, 0);
+    cvec_x_set_size(vec, 0);
+#ifdef CVEC_INCREMENTAL
+    cvec_x_truncate_old(vec, 0);
+#endif
+    cvec_x_resize_parallel(vec, count, value, threads);
+}
+#endif
+
 //
 // Private functions
 //
@@ -435,27 +1343,402 @@ CVEC_TYPE *cvec_x_insert_it(CVEC_TYPE **vec, CVEC_TYPE *it, CVEC_TYPE value) {
 static void cvec_x_set_capacity(CVEC_TYPE **vec, size_t size) {
     CVEC_ASSERT(vec);
     if (*vec) {
-        ((size_t *)*vec)[-1] = size;
+        ((CVEC_HDR_T *)*vec)[-1] = size;
     }
 }
 
 static void cvec_x_set_size(CVEC_TYPE **vec, size_t size) {
     CVEC_ASSERT(vec);
     if (*vec) {
-        ((size_t *)*vec)[-2] = size;
+        ((CVEC_HDR_T *)*vec)[-2] = size;
     }
 }
 
 static void cvec_x_grow(CVEC_TYPE **vec, size_t count) {
     CVEC_ASSERT(vec);
-    const size_t cv_sz = count * sizeof(**vec) + sizeof(size_t) * 2;
-    size_t *cv_p1 = &((size_t *)*vec)[-2];
-    size_t *cv_p2 = CVEC_REALLOC(cv_p1, (cv_sz));
+#ifdef CVEC_COW
+    if (cvec_x_use_count(vec) > 1) {
+        cvec_x_unshare(vec, count, count);
+        return;
+    }
+#endif
+    // Empty vectors are represented by NULL and own no buffer
+    if (count == 0) {
+        cvec_x_free(vec);
+        return;
+    }
+    if (!*vec) {
+        *vec = cvec_x_alloc(count, 1);
+        return;
+    }
+#ifdef CVEC_INCREMENTAL
+    CVEC_SETTLE(vec);
+    const size_t cv_size = cvec_x_size(vec);
+    if (cv_size && count > cvec_x_capacity(vec) && cv_size * sizeof(CVEC_TYPE) >= CVEC_INCREMENTAL_MIN) {
+        // Elements are moved from the old buffer later on, see cvec_x_migrate_step
+        CVEC_TYPE *old = *vec;
+        *vec = cvec_x_new(count);
+        cvec_x_set_size(vec, cv_size);
+        *cvec_x_old(vec) = old;
+        *cvec_x_old_count(vec) = cv_size;
+        return;
+    }
+#endif
+    const size_t cv_old_cap = cvec_x_capacity(vec);
+#ifdef CVEC_CACHE
+    const unsigned cv_class = cvec_x_size_class(CVEC_BUF_SIZE(count));
+    if (cv_class <= CVEC_CACHE_MAX_SHIFT && !CVEC_MAPPED((size_t)1 << cv_class)) {
+        // Move into a buffer of the size class, recycle the old one
+        const size_t cv_cap = (((size_t)1 << cv_class) - CVEC_BUF_SIZE(0)) / sizeof(CVEC_TYPE);
+        if (cv_cap != cv_old_cap) {
+            cvec_x_move(vec, count, cv_cap > cv_old_cap);
+        }
+        return;
+    }
+#endif
+    CVEC_ASSERT(count <= CVEC_SIZE_MAX);
+    const size_t cv_sz = CVEC_BUF_SIZE(count);
+    const size_t cv_old_sz = CVEC_BUF_SIZE(cv_old_cap);
+    if (CVEC_MAPPED(cv_sz) != CVEC_MAPPED(cv_old_sz)) {
+        // Move between the heap and a mapping of its own
+        cvec_x_move(vec, count, count > cv_old_cap);
+        return;
+    }
+#ifdef CVEC_BUDGET
+    cvec_budget_sub(cv_old_sz);
+#endif
+    CVEC_HDR_T *cv_p1 = CVEC_HDR(vec);
+#ifdef CVEC_NUMA
+    CVEC_HDR_T *cv_p2 = CVEC_MAPPED(cv_sz) ? cvec_numa_remap(cv_p1, cv_old_sz, cv_sz)
+                                           : CVEC_REALLOC(cv_p1, cv_sz);
+#else
+    CVEC_HDR_T *cv_p2 = CVEC_REALLOC(cv_p1, (cv_sz));
+#endif
     CVEC_ASSERT(cv_p2);
-    *vec = (void *)(&cv_p2[2]);
+    *vec = (void *)(&cv_p2[CVEC_HDR_LEN]);
     cvec_x_set_capacity(vec, count);
+#ifdef CVEC_BUDGET
+    cvec_budget_add(cv_sz, count > cv_old_cap);
+#endif
+}
+
+static CVEC_TYPE *cvec_x_alloc(size_t count, int grown) {
+    (void)grown;
+    CVEC_ASSERT(count <= CVEC_SIZE_MAX);
+    size_t cv_sz = CVEC_BUF_SIZE(count);
+    CVEC_HDR_T *cv_p = NULL;
+#ifdef CVEC_CACHE
+    const unsigned cv_class = cvec_x_size_class(cv_sz);
+    if (cv_class <= CVEC_CACHE_MAX_SHIFT && !CVEC_MAPPED((size_t)1 << cv_class)) {
+        // Allocate the whole size class so that the buffer is reusable by any vector
+        cv_sz = (size_t)1 << cv_class;
+        count = (cv_sz - CVEC_BUF_SIZE(0)) / sizeof(CVEC_TYPE);
+        cv_p = cvec_cache_take(cv_class);
+    }
+#endif
+#ifdef CVEC_NUMA
+    if (CVEC_MAPPED(cv_sz)) {
+        // The policy is set before the first touch and goes away with the mapping. Release and
+        // grow tell mapped buffers by their size, so there's no falling back to CVEC_MALLOC.
+        cv_p = cvec_numa_map(cv_sz);
+        CVEC_ASSERT(cv_p);
+    }
+#endif
+    if (!cv_p) {
+        cv_p = CVEC_MALLOC(cv_sz);
+    }
+    CVEC_ASSERT(cv_p);
+#ifdef CVEC_BUDGET
+    cvec_budget_add(CVEC_BUF_SIZE(count), grown);
+#endif
+    CVEC_TYPE *vec = (void *)(&cv_p[CVEC_HDR_LEN]);
+    cvec_x_set_capacity(&vec, count);
+    cvec_x_set_size(&vec, 0);
+#ifdef CVEC_COW
+    *cvec_x_refcount(&vec) = 1;
+#endif
+#ifdef CVEC_INCREMENTAL
+    *cvec_x_old(&vec) = NULL;
+    *cvec_x_migrated(&vec) = 0;
+    *cvec_x_old_count(&vec) = 0;
+#endif
+    return vec;
+}
+
+static void cvec_x_release(CVEC_TYPE **vec) {
+    CVEC_ASSERT(vec);
+#ifdef CVEC_BUDGET
+    cvec_budget_sub(CVEC_BUF_SIZE(cvec_x_capacity(vec)));
+#endif
+    CVEC_HDR_T *p1 = CVEC_HDR(vec);
+#ifdef CVEC_NUMA
+    if (CVEC_MAPPED(CVEC_BUF_SIZE(cvec_x_capacity(vec)))) {
+        cvec_numa_unmap(p1, CVEC_BUF_SIZE(cvec_x_capacity(vec)));
+        return;
+    }
+#endif
+#ifdef CVEC_CACHE
+    const unsigned cv_class = cvec_x_size_class(CVEC_BUF_SIZE(cvec_x_capacity(vec)));
+    if (cv_class <= CVEC_CACHE_MAX_SHIFT && cvec_cache_put(p1, cv_class)) {
+        return;
+    }
+#endif
+    CVEC_FREE(p1);
+}
+
+static void cvec_x_move(CVEC_TYPE **vec, size_t count, int grown) {
+    CVEC_TYPE *cv_new = cvec_x_alloc(count, grown);
+    const size_t cv_keep = cvec_x_size(vec) < count ? cvec_x_size(vec) : count;
+    for (size_t i = 0; i < cv_keep; i++) {
+        cv_new[i] = (*vec)[i];
+    }
+    cvec_x_set_size(&cv_new, cv_keep);
+    cvec_x_release(vec);
+    *vec = cv_new;
+}
+
+#ifdef CVEC_COW
+static CVEC_HDR_T *cvec_x_refcount(CVEC_TYPE **vec) {
+    CVEC_ASSERT(vec);
+    return &((CVEC_HDR_T *)*vec)[-3];
+}
+
+static void cvec_x_unshare(CVEC_TYPE **vec, size_t count, size_t keep) {
+    CVEC_ASSERT(vec);
+    const size_t size = cvec_x_size(vec);
+    CVEC_TYPE *new_vec = cvec_x_new(count);
+    if (keep > size) {
+        keep = size;
+    }
+    if (keep > count) {
+        keep = count;
+    }
+    for (size_t i = 0; i < keep; i++) {
+        new_vec[i] = (*vec)[i];
+    }
+    cvec_x_set_size(&new_vec, keep);
+    cvec_x_free(vec);
+    *vec = new_vec;
+}
+
+static void cvec_x_detach(CVEC_TYPE **vec, size_t keep) {
+    if (cvec_x_use_count(vec) > 1) {
+        if (keep == 0) {
+            // Nothing to copy, so just drop the reference, the caller takes a buffer it needs
+            cvec_x_free(vec);
+        } else {
+            cvec_x_unshare(vec, cvec_x_capacity(vec), keep);
+        }
+    }
+}
+#endif
+
+#if defined(CVEC_SHRINK) || defined(CVEC_BUDGET)
+static void cvec_x_auto_shrink(CVEC_TYPE **vec) {
+    const size_t size = cvec_x_size(vec);
+    const size_t cap = cvec_x_capacity(vec);
+#ifdef CVEC_BUDGET
+    if (cvec_budget_exceeded()) {
+        // Trim at the same threshold as the shrink policy does, but right to twice the size, so
+        // that push_back/pop_back churn doesn't reallocate each time under the pressure either
+        if (size <= cap / CVEC_SHRINK_THRESHOLD && size * CVEC_SHRINK_FACTOR < cap) {
+            cvec_x_grow(vec, size * CVEC_SHRINK_FACTOR);
+        }
+        return;
+    }
+#endif
+#ifdef CVEC_SHRINK
+    // Leave capacity / CVEC_SHRINK_FACTOR - size free slots so that push_back/pop_back churn
+    // at the boundary doesn't reallocate each time
+    size_t new_cap = cap;
+    while (new_cap / CVEC_SHRINK_FACTOR >= CVEC_SHRINK_MIN && size < new_cap / CVEC_SHRINK_THRESHOLD) {
+        new_cap /= CVEC_SHRINK_FACTOR;
+    }
+    if (new_cap < cap) {
+        cvec_x_grow(vec, new_cap);
+    }
+#endif
+}
+#endif
+
+#ifdef CVEC_INCREMENTAL
+static CVEC_TYPE **cvec_x_old(CVEC_TYPE **vec) {
+    CVEC_ASSERT(vec);
+    return (CVEC_TYPE **)&((size_t *)*vec)[-3];
+}
+
+static size_t *cvec_x_migrated(CVEC_TYPE **vec) {
+    CVEC_ASSERT(vec);
+    return &((size_t *)*vec)[-4];
+}
+
+static size_t *cvec_x_old_count(CVEC_TYPE **vec) {
+    CVEC_ASSERT(vec);
+    return &((size_t *)*vec)[-5];
+}
+
+static CVEC_TYPE *cvec_x_elem(CVEC_TYPE **vec, size_t i) {
+    CVEC_ASSERT(vec);
+    CVEC_TYPE *old = *vec ? *cvec_x_old(vec) : NULL;
+    if (old && i >= *cvec_x_migrated(vec) && i < *cvec_x_old_count(vec)) {
+        return &old[i];
+    }
+    return &(*vec)[i];
+}
+
+static void cvec_x_migrate_step(CVEC_TYPE **vec) {
+    if (!*vec || !*cvec_x_old(vec)) {
+        return;
+    }
+    // Move the elements left at the pace of free space consumption by push_back
+    const size_t left = *cvec_x_old_count(vec) - *cvec_x_migrated(vec);
+    const size_t cap = cvec_x_capacity(vec);
+    const size_t size = cvec_x_size(vec);
+    const size_t room = cap > size ? cap - size : 1;
+    const size_t step = (left + room - 1) / room;
+    cvec_x_migrate(vec, step > CVEC_INCREMENTAL_STEP ? step : CVEC_INCREMENTAL_STEP);
 }
 
+static void cvec_x_discard_old(CVEC_TYPE *old, size_t from, size_t to) {
+    const uintptr_t mask = ~(uintptr_t)(CVEC_DISCARD_CHUNK - 1);
+    const uintptr_t base = ((uintptr_t)old + CVEC_DISCARD_CHUNK - 1) & mask;
+    const uintptr_t first = (uintptr_t)(old + from) & mask;
+    const uintptr_t last = (uintptr_t)(old + to) & mask;
+    // Chunks are given back once the last element of each is moved, never before the buffer
+    const uintptr_t lo = first > base ? first : base;
+    if (last > lo) {
+        CVEC_DISCARD((void *)lo, last - lo);
+    }
+}
+
+static void cvec_x_truncate_old(CVEC_TYPE **vec, size_t size) {
+    if (!*vec || !*cvec_x_old(vec)) {
+        return;
+    }
+    if (*cvec_x_old_count(vec) > size) {
+        *cvec_x_old_count(vec) = size;
+    }
+    cvec_x_migrate(vec, 0);
+}
+#endif
+
+#ifdef CVEC_CACHE
+static unsigned cvec_x_size_class(size_t bytes) {
+    unsigned shift = CVEC_CACHE_MIN_SHIFT;
+    while (shift <= CVEC_CACHE_MAX_SHIFT && ((size_t)1 << shift) < bytes) {
+        shift++;
+    }
+    return shift;
+}
+#endif
+
+static void cvec_x_gather_data(CVEC_TYPE *dst, const CVEC_TYPE *src, const size_t *idx, size_t n) {
+    size_t i = 0;
+#ifdef __AVX2__
+    // Gather 4 elements by a single instruction if they fit into 32-bit or 64-bit lanes
+    if ((sizeof(CVEC_TYPE) == 4 || sizeof(CVEC_TYPE) == 8) && sizeof(size_t) == 8) {
+        for (; i + 4 <= n; i += 4) {
+            if (i + CVEC_PREFETCH_DISTANCE + 4 <= n) {
+                const size_t *ahead = &idx[i + CVEC_PREFETCH_DISTANCE];
+                CVEC_PREFETCH(&src[ahead[0]], 0);
+                CVEC_PREFETCH(&src[ahead[1]], 0);
+                CVEC_PREFETCH(&src[ahead[2]], 0);
+                CVEC_PREFETCH(&src[ahead[3]], 0);
+            }
+            const __m256i vidx = _mm256_loadu_si256((const __m256i *)&idx[i]);
+            if (sizeof(CVEC_TYPE) == 4) {
+                _mm_storeu_si128((__m128i *)&dst[i], _mm256_i64gather_epi32((const int *)src, vidx, 4));
+            } else {
+                _mm256_storeu_si256((__m256i *)&dst[i],
+                                    _mm256_i64gather_epi64((const long long *)src, vidx, 8));
+            }
+        }
+    }
+#endif
+    for (; i < n; i++) {
+        if (i + CVEC_PREFETCH_DISTANCE < n) {
+            CVEC_PREFETCH(&src[idx[i + CVEC_PREFETCH_DISTANCE]], 0);
+        }
+        dst[i] = src[idx[i]];
+    }
+}
+
+#ifdef CVEC_NUMA
+static void *cvec_x_fill_part(void *job) {
+    struct cvec_x_fill_job *part = job;
+#ifdef CPU_SET
+    if (part->cpu >= 0) {
+        // Pin the thread before it touches the part, otherwise it may move to another node after
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(part->cpu, &cpus);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    }
+#endif
+    for (size_t i = 0; i < part->count; i++) {
+        part->first[i] = part->value;
+    }
+    return NULL;
+}
+
+static void cvec_x_fill_parallel(CVEC_TYPE *first, size_t count, CVEC_TYPE value, unsigned threads) {
+    if (count == 0) {
+        return;
+    }
+    if (threads == 0) {
+        threads = cvec_numa_cpus();
+    }
+    if (threads > count) {
+        threads = count;
+    }
+    struct cvec_x_fill_job *jobs = CVEC_MALLOC(threads * sizeof(*jobs));
+    pthread_t *ids = CVEC_MALLOC(threads * sizeof(*ids));
+    CVEC_ASSERT(jobs && ids);
+#ifdef CPU_SET
+    // Parts are given to the CPUs the calling thread may run on round-robin
+    cpu_set_t allowed;
+    int pin = threads > 1 && pthread_getaffinity_np(pthread_self(), sizeof(allowed), &allowed) == 0;
+    int cpu = -1;
+#endif
+    for (unsigned t = 0; t < threads; t++) {
+        const size_t begin = count / threads * t + (t < count % threads ? t : count % threads);
+        const size_t end = begin + count / threads + (t < count % threads);
+        jobs[t].first = first + begin;
+        jobs[t].count = end - begin;
+        jobs[t].value = value;
+        jobs[t].cpu = -1;
+#ifdef CPU_SET
+        if (pin) {
+            do {
+                cpu = (cpu + 1) % CPU_SETSIZE;
+            } while (!CPU_ISSET(cpu, &allowed));
+            jobs[t].cpu = cpu;
+        }
+#endif
+    }
+    // Pinned parts are set by threads of their own, otherwise the calling thread sets the first
+    // part. Parts of threads failed to start are set by the calling thread unpinned.
+    const unsigned first_thread = jobs[0].cpu >= 0 ? 0 : 1;
+    for (unsigned t = first_thread; t < threads; t++) {
+        if (pthread_create(&ids[t], NULL, cvec_x_fill_part, &jobs[t]) != 0) {
+            jobs[t].cpu = -1;
+            cvec_x_fill_part(&jobs[t]);
+            jobs[t].count = 0;
+        }
+    }
+    if (first_thread) {
+        cvec_x_fill_part(&jobs[0]);
+    }
+    for (unsigned t = first_thread; t < threads; t++) {
+        if (jobs[t].count) {
+            pthread_join(ids[t], NULL);
+        }
+    }
+    CVEC_FREE(jobs);
+    CVEC_FREE(ids);
+}
+#endif
+
 #endif
 
 #undef CVEC_TYPE
@@ -475,7 +1758,61 @@ static void cvec_x_grow(CVEC_TYPE **vec, size_t count) {
 #   undef CVEC_MALLOC
 #   undef CVEC_REALLOC
 #   undef CVEC_FREE
+#   undef CVEC_ATOMIC_ADD
+#   undef CVEC_ATOMIC_SUB
+#   undef CVEC_ATOMIC_LOAD
+#   undef CVEC_SHRINK_THRESHOLD
+#   undef CVEC_SHRINK_FACTOR
+#   undef CVEC_SHRINK_MIN
+#   undef CVEC_INCREMENTAL_MIN
+#   undef CVEC_INCREMENTAL_STEP
+#   undef CVEC_DISCARD
+#   undef CVEC_DISCARD_CHUNK
+#   undef CVEC_CACHE_MIN_SHIFT
+#   undef CVEC_CACHE_MAX_SHIFT
+#   undef CVEC_CACHE_DEPTH
+#   undef CVEC_CACHE_BYTES
+#   undef CVEC_THREAD_LOCAL
+#   undef CVEC_PREFETCH
+#   undef CVEC_PREFETCH_DISTANCE
+#   undef CVEC_NUMA_MIN
+#endif
+
+#ifdef CVEC_COW
+#   undef CVEC_COW
+#endif
+#ifdef CVEC_SHRINK
+#   undef CVEC_SHRINK
+#endif
+#ifdef CVEC_INCREMENTAL
+#   undef CVEC_INCREMENTAL
 #endif
+#ifdef CVEC_CACHE
+#   undef CVEC_CACHE
+#endif
+#ifdef CVEC_BUDGET
+#   undef CVEC_BUDGET
+#endif
+#ifdef CVEC_COMPACT
+#   undef CVEC_COMPACT
+#endif
+#ifdef CVEC_NUMA
+#   undef CVEC_NUMA
+#endif
+#ifdef CVEC_GLOBAL_INST
+#   undef CVEC_GLOBAL_INST
+#endif
+
+#undef CVEC_HDR_T
+#undef CVEC_SIZE_MAX
+#undef CVEC_HDR_LEN
+#undef CVEC_HDR
+#undef CVEC_BUF_SIZE
+#undef CVEC_DETACH
+#undef CVEC_ELEM
+#undef CVEC_SETTLE
+#undef CVEC_MAPPED
+#undef CVEC_AUTO_SHRINK
 
 #undef CVEC_CONCAT2_IMPL
 #undef CVEC_CONCAT2
@@ -486,6 +1823,7 @@ static void cvec_x_grow(CVEC_TYPE **vec, size_t count) {
 #undef cvec_x_capacity
 #undef cvec_x_size
 #undef cvec_x_empty
+#undef cvec_x_pop_front
 #undef cvec_x_pop_back
 #undef cvec_x_erase
 #undef cvec_x_free
@@ -494,6 +1832,7 @@ static void cvec_x_grow(CVEC_TYPE **vec, size_t count) {
 #undef cvec_x_end
 #undef cvec_x_cend
 #undef cvec_x_push_back
+#undef cvec_x_extend
 #undef cvec_x_at
 #undef cvec_x_reserve
 #undef cvec_x_shrink_to_fit
@@ -511,6 +1850,34 @@ static void cvec_x_grow(CVEC_TYPE **vec, size_t count) {
 #undef cvec_x_max_size
 #undef cvec_x_insert
 #undef cvec_x_insert_it
+#undef cvec_x_set
+#undef cvec_x_gather
+#undef cvec_x_scatter
+#undef cvec_x_permute
+#undef cvec_x_apply_permutation
+#undef cvec_x_share
+#undef cvec_x_use_count
+#undef cvec_x_migrate
+#undef cvec_x_resize_parallel
+#undef cvec_x_assign_fill_parallel
 #undef cvec_x_grow
 #undef cvec_x_set_capacity
 #undef cvec_x_set_size
+#undef cvec_x_refcount
+#undef cvec_x_detach
+#undef cvec_x_unshare
+#undef cvec_x_auto_shrink
+#undef cvec_x_old
+#undef cvec_x_migrated
+#undef cvec_x_old_count
+#undef cvec_x_elem
+#undef cvec_x_migrate_step
+#undef cvec_x_truncate_old
+#undef cvec_x_alloc
+#undef cvec_x_release
+#undef cvec_x_move
+#undef cvec_x_size_class
+#undef cvec_x_gather_data
+#undef cvec_x_fill_job
+#undef cvec_x_fill_part
+#undef cvec_x_fill_parallel
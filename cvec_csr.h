@@ -0,0 +1,244 @@
+// Copyright (c) 2020 Magomed Kostoev
+//
+// You may use, distribute and modify this code under the terms of the MIT license.
+//
+// You should have received a copy of the MIT license with this file. If not, please visit
+// https://opensource.org/licenses/MIT for full license details.
+
+// cvec_csr.h - vector of vectors packed into a single buffer (compressed sparse row layout).
+//
+// Elements of all the rows are placed one after another in a single vector, and another vector
+// holds offset of each row in it followed by the end of the last row. Unlike vector of vectors it
+// has no allocation and no header for each row, and rows are placed close to each other.
+//
+// Rows are built by pushing elements to the last row and closing it by end_row or by appending
+// whole rows by append_row, the buffer grows geometrically in both cases, so its growth is
+// amortized across all the rows.
+//
+// Configuration (definitions):
+// CVEC_TYPE:    Type of the rows' elements, after instantiation the container type will be
+//               visible as cvec_csr_<CVEC_TYPE> and its functions as cvec_csr_<CVEC_TYPE>_funcname
+// CVEC_INST:    Instantiate the functions if defined
+// CVEC_ASSERT:  Replacement for assert from <assert.h>
+//
+// Minimal definitions for declaration: CVEC_TYPE
+// Minimal definitions for instantiation: CVEC_TYPE, CVEC_INST
+//
+// WARNING: All used definitions will be undefined on header exit.
+//
+// WARNING: The container type is defined on each inclusion, so include the header once for each
+// CVEC_TYPE in a translation unit (with CVEC_INST defined or not).
+//
+// Dependencies:
+// cvec.h included for CVEC_TYPE and for size_t (and instantiated somewhere in the program)
+// <assert.h> or another source of assert
+
+//
+// Input macros
+//
+
+#ifndef CVEC_ASSERT
+#   define CVEC_ASSERT(x) assert(x)
+#endif
+
+//
+// Internal macros
+//
+
+#define CVEC_CSR_CONCAT1_IMPL(x) cvec_csr_ ## x
+#define CVEC_CSR_CONCAT1(x) CVEC_CSR_CONCAT1_IMPL(x)
+#define CVEC_CSR_CONCAT2_IMPL(x, y) cvec_csr_ ## x ## _ ## y
+#define CVEC_CSR_CONCAT2(x, y) CVEC_CSR_CONCAT2_IMPL(x, y)
+#define CVEC_CONCAT2_IMPL(x, y) cvec_ ## x ## _ ## y
+#define CVEC_CONCAT2(x, y) CVEC_CONCAT2_IMPL(x, y)
+
+/// Creates method name according to CVEC_TYPE
+#define CVEC_CSR_FUN(name) CVEC_CSR_CONCAT2(CVEC_TYPE, name)
+
+/// Creates name of the vector method according to CVEC_TYPE
+#define CVEC_FUN(name) CVEC_CONCAT2(CVEC_TYPE, name)
+
+#define cvec_csr_x CVEC_CSR_CONCAT1(CVEC_TYPE)
+#define cvec_csr_x_init CVEC_CSR_FUN(init)
+#define cvec_csr_x_free CVEC_CSR_FUN(free)
+#define cvec_csr_x_rows CVEC_CSR_FUN(rows)
+#define cvec_csr_x_size CVEC_CSR_FUN(size)
+#define cvec_csr_x_reserve CVEC_CSR_FUN(reserve)
+#define cvec_csr_x_push_back CVEC_CSR_FUN(push_back)
+#define cvec_csr_x_end_row CVEC_CSR_FUN(end_row)
+#define cvec_csr_x_append_row CVEC_CSR_FUN(append_row)
+#define cvec_csr_x_pack CVEC_CSR_FUN(pack)
+#define cvec_csr_x_row_begin CVEC_CSR_FUN(row_begin)
+#define cvec_csr_x_row_end CVEC_CSR_FUN(row_end)
+#define cvec_csr_x_row_size CVEC_CSR_FUN(row_size)
+
+#define cvec_x_new CVEC_FUN(new)
+#define cvec_x_free CVEC_FUN(free)
+#define cvec_x_size CVEC_FUN(size)
+#define cvec_x_reserve CVEC_FUN(reserve)
+#define cvec_x_extend CVEC_FUN(extend)
+#define cvec_x_push_back CVEC_FUN(push_back)
+#define cvec_x_data CVEC_FUN(data)
+#define cvec_x_cbegin CVEC_FUN(cbegin)
+
+//
+// External declarations
+//
+
+typedef struct {
+    CVEC_TYPE *values; // Elements of all the rows
+    size_t *offsets; // Offset of each row in values and the end of the last row
+} cvec_csr_x;
+
+/// Initializes an empty container.
+void cvec_csr_x_init(cvec_csr_x *csr);
+
+/// Frees all memory associated with the container.
+void cvec_csr_x_free(cvec_csr_x *csr);
+
+/// Gets count of rows (not including the one being built by push_back).
+size_t cvec_csr_x_rows(cvec_csr_x *csr);
+
+/// Gets count of elements in all the rows.
+size_t cvec_csr_x_size(cvec_csr_x *csr);
+
+/// Reserves space for rows and for values in them.
+void cvec_csr_x_reserve(cvec_csr_x *csr, size_t rows, size_t values);
+
+/// Adds an element to the end of the row being built.
+void cvec_csr_x_push_back(cvec_csr_x *csr, CVEC_TYPE value);
+
+/// Finishes the row being built, so the next push_back adds an element to a new row.
+void cvec_csr_x_end_row(cvec_csr_x *csr);
+
+/// Adds count elements to the row being built and finishes it, returns the row.
+CVEC_TYPE *cvec_csr_x_append_row(cvec_csr_x *csr, const CVEC_TYPE *row, size_t count);
+
+/// Adds each of count vectors as a row, allocates the space for all of them at once.
+void cvec_csr_x_pack(cvec_csr_x *csr, CVEC_TYPE **rows, size_t count);
+
+/// Returns an iterator to first element of the row.
+CVEC_TYPE *cvec_csr_x_row_begin(cvec_csr_x *csr, size_t row);
+
+/// Returns an iterator to one past the last element of the row.
+CVEC_TYPE *cvec_csr_x_row_end(cvec_csr_x *csr, size_t row);
+
+/// Gets count of elements in the row.
+size_t cvec_csr_x_row_size(cvec_csr_x *csr, size_t row);
+
+//
+// Function definitions
+//
+
+#ifdef CVEC_INST
+
+void cvec_csr_x_init(cvec_csr_x *csr) {
+    csr->values = cvec_x_new(0);
+    csr->offsets = cvec_size_t_new(1);
+    cvec_size_t_push_back(&csr->offsets, 0);
+}
+
+void cvec_csr_x_free(cvec_csr_x *csr) {
+    cvec_x_free(&csr->values);
+    cvec_size_t_free(&csr->offsets);
+}
+
+size_t cvec_csr_x_rows(cvec_csr_x *csr) {
+    return cvec_size_t_size(&csr->offsets) - 1;
+}
+
+size_t cvec_csr_x_size(cvec_csr_x *csr) {
+    return cvec_size_t_back(&csr->offsets);
+}
+
+void cvec_csr_x_reserve(cvec_csr_x *csr, size_t rows, size_t values) {
+    cvec_size_t_reserve(&csr->offsets, rows + 1);
+    cvec_x_reserve(&csr->values, values);
+}
+
+void cvec_csr_x_push_back(cvec_csr_x *csr, CVEC_TYPE value) {
+    cvec_x_push_back(&csr->values, value);
+}
+
+void cvec_csr_x_end_row(cvec_csr_x *csr) {
+    cvec_size_t_push_back(&csr->offsets, cvec_x_size(&csr->values));
+}
+
+CVEC_TYPE *cvec_csr_x_append_row(cvec_csr_x *csr, const CVEC_TYPE *row, size_t count) {
+    // Grow geometrically as push_back does and copy right into the new space
+    CVEC_TYPE *dst = cvec_x_extend(&csr->values, count);
+    for (size_t i = 0; i < count; i++) {
+        dst[i] = row[i];
+    }
+    cvec_csr_x_end_row(csr);
+    return cvec_csr_x_row_begin(csr, cvec_csr_x_rows(csr) - 1);
+}
+
+void cvec_csr_x_pack(cvec_csr_x *csr, CVEC_TYPE **rows, size_t count) {
+    size_t total = 0;
+    for (size_t r = 0; r < count; r++) {
+        total += cvec_x_size(&rows[r]);
+    }
+    cvec_csr_x_reserve(csr, cvec_csr_x_rows(csr) + count, cvec_x_size(&csr->values) + total);
+    for (size_t r = 0; r < count; r++) {
+        cvec_csr_x_append_row(csr, cvec_x_cbegin(&rows[r]), cvec_x_size(&rows[r]));
+    }
+}
+
+CVEC_TYPE *cvec_csr_x_row_begin(cvec_csr_x *csr, size_t row) {
+    CVEC_ASSERT(row < cvec_csr_x_rows(csr));
+    return cvec_x_data(&csr->values) + cvec_size_t_data(&csr->offsets)[row];
+}
+
+CVEC_TYPE *cvec_csr_x_row_end(cvec_csr_x *csr, size_t row) {
+    CVEC_ASSERT(row < cvec_csr_x_rows(csr));
+    return cvec_x_data(&csr->values) + cvec_size_t_data(&csr->offsets)[row + 1];
+}
+
+size_t cvec_csr_x_row_size(cvec_csr_x *csr, size_t row) {
+    CVEC_ASSERT(row < cvec_csr_x_rows(csr));
+    const size_t *offsets = cvec_size_t_data(&csr->offsets);
+    return offsets[row + 1] - offsets[row];
+}
+
+#endif
+
+#undef CVEC_TYPE
+
+#ifdef CVEC_INST
+#   undef CVEC_INST
+#   undef CVEC_ASSERT
+#endif
+
+#undef CVEC_CSR_CONCAT1_IMPL
+#undef CVEC_CSR_CONCAT1
+#undef CVEC_CSR_CONCAT2_IMPL
+#undef CVEC_CSR_CONCAT2
+#undef CVEC_CONCAT2_IMPL
+#undef CVEC_CONCAT2
+
+#undef CVEC_CSR_FUN
+#undef CVEC_FUN
+
+#undef cvec_csr_x
+#undef cvec_csr_x_init
+#undef cvec_csr_x_free
+#undef cvec_csr_x_rows
+#undef cvec_csr_x_size
+#undef cvec_csr_x_reserve
+#undef cvec_csr_x_push_back
+#undef cvec_csr_x_end_row
+#undef cvec_csr_x_append_row
+#undef cvec_csr_x_pack
+#undef cvec_csr_x_row_begin
+#undef cvec_csr_x_row_end
+#undef cvec_csr_x_row_size
+
+#undef cvec_x_new
+#undef cvec_x_free
+#undef cvec_x_size
+#undef cvec_x_reserve
+#undef cvec_x_extend
+#undef cvec_x_push_back
+#undef cvec_x_data
+#undef cvec_x_cbegin
@@ -0,0 +1,273 @@
+// Copyright (c) 2020 Magomed Kostoev
+//
+// You may use, distribute and modify this code under the terms of the MIT license.
+//
+// You should have received a copy of the MIT license with this file. If not, please visit
+// https://opensource.org/licenses/MIT for full license details.
+
+// cvec_delta.h - append-only compressed vector of non-decreasing 64-bit integers (sorted IDs).
+//
+// Values are stored by blocks of CVEC_DELTA_BLOCK values. Differences between neighbour values of
+// a full block are bit-packed using the width of the biggest one, so the block takes 16 bytes
+// per bit of the width. Values of a block are interleaved between two lanes of 64-bit words, so
+// SSE2 unpacks two of them at once. The skip index holds the first value, the packed data offset
+// and the bit width of each full block. The last incomplete block is stored as is.
+//
+// Configuration (definitions):
+// CVEC_DELTA_INST: Instantiate the functions if defined
+//
+// Minimal definitions for declaration: none
+// Minimal definitions for instantiation: CVEC_DELTA_INST
+//
+// Dependencies:
+// cvec.h instantiated for uint64_t somewhere in the program
+// <stdint.h> or another source of uint64_t
+// <emmintrin.h> if __SSE2__ is defined
+
+#ifndef CVEC_DELTA_DECLARED
+#define CVEC_DELTA_DECLARED
+
+#define CVEC_TYPE uint64_t
+#include "cvec.h"
+
+/// Count of values in a block
+#define CVEC_DELTA_BLOCK 128
+
+typedef struct cvec_delta {
+    uint64_t *words; // Packed differences of the full blocks
+    uint64_t *index; // (first value, offset in words << 8 | bit width) pair for each full block
+    uint64_t tail[CVEC_DELTA_BLOCK]; // Values of the last incomplete block
+    size_t tail_size;
+    uint64_t last;
+} cvec_delta;
+
+/// Initializes an empty compressed vector.
+void cvec_delta_init(cvec_delta *dv);
+
+/// Frees all memory associated with the compressed vector.
+void cvec_delta_free(cvec_delta *dv);
+
+/// Gets count of values in the compressed vector.
+size_t cvec_delta_size(cvec_delta *dv);
+
+/// Gets count of bytes used to store the values (packed data, skip index and the last block).
+size_t cvec_delta_bytes(cvec_delta *dv);
+
+/// Adds a value to the end of the compressed vector, it should not be less than the last one.
+void cvec_delta_push_back(cvec_delta *dv, uint64_t value);
+
+/// Gets value at index i (should be less than size), decodes the whole block.
+uint64_t cvec_delta_at(cvec_delta *dv, size_t i);
+
+/// Returns index of the first value not less than the given one (size if there's no such value).
+size_t cvec_delta_lower_bound(cvec_delta *dv, uint64_t value);
+
+/// Replaces the contents of the vector with all the values of the compressed vector.
+void cvec_delta_decompress_into(cvec_delta *dv, uint64_t **vec);
+
+#endif
+
+#if defined(CVEC_DELTA_INST) && !defined(CVEC_DELTA_INSTANTIATED)
+#define CVEC_DELTA_INSTANTIATED
+
+#ifdef __SSE2__
+#   include <emmintrin.h>
+#endif
+
+/// Packs the last block into the words, adds it to the skip index.
+static void cvec_delta_encode(cvec_delta *dv);
+
+/// Unpacks a block of values into out.
+static void cvec_delta_decode(const uint64_t *words, unsigned bits, uint64_t base, uint64_t *out);
+
+/// Unpacks the block number b into out.
+static void cvec_delta_decode_block(cvec_delta *dv, size_t b, uint64_t *out);
+
+//
+// Public functions
+//
+
+void cvec_delta_init(cvec_delta *dv) {
+    dv->words = cvec_uint64_t_new(0);
+    dv->index = cvec_uint64_t_new(0);
+    dv->tail_size = 0;
+    dv->last = 0;
+}
+
+void cvec_delta_free(cvec_delta *dv) {
+    cvec_uint64_t_free(&dv->words);
+    cvec_uint64_t_free(&dv->index);
+}
+
+size_t cvec_delta_size(cvec_delta *dv) {
+    return cvec_uint64_t_size(&dv->index) / 2 * CVEC_DELTA_BLOCK + dv->tail_size;
+}
+
+size_t cvec_delta_bytes(cvec_delta *dv) {
+    return (cvec_uint64_t_size(&dv->words) + cvec_uint64_t_size(&dv->index) + dv->tail_size)
+        * sizeof(uint64_t);
+}
+
+void cvec_delta_push_back(cvec_delta *dv, uint64_t value) {
+    CVEC_ASSERT(cvec_delta_size(dv) == 0 || value >= dv->last);
+    dv->tail[dv->tail_size++] = value;
+    dv->last = value;
+    if (dv->tail_size == CVEC_DELTA_BLOCK) {
+        cvec_delta_encode(dv);
+        dv->tail_size = 0;
+    }
+}
+
+uint64_t cvec_delta_at(cvec_delta *dv, size_t i) {
+    const size_t blocks = cvec_uint64_t_size(&dv->index) / 2;
+    CVEC_ASSERT(i < cvec_delta_size(dv));
+    if (i >= blocks * CVEC_DELTA_BLOCK) {
+        return dv->tail[i - blocks * CVEC_DELTA_BLOCK];
+    }
+    uint64_t values[CVEC_DELTA_BLOCK];
+    cvec_delta_decode_block(dv, i / CVEC_DELTA_BLOCK, values);
+    return values[i % CVEC_DELTA_BLOCK];
+}
+
+size_t cvec_delta_lower_bound(cvec_delta *dv, uint64_t value) {
+    const uint64_t *index = cvec_uint64_t_data(&dv->index);
+    const size_t blocks = cvec_uint64_t_size(&dv->index) / 2;
+    // Find count of blocks starting from a value less than the given one
+    size_t lo = 0, hi = blocks;
+    while (lo < hi) {
+        const size_t mid = lo + (hi - lo) / 2;
+        if (index[mid * 2] < value) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    // The value may be inside of the last such block
+    if (lo > 0) {
+        uint64_t values[CVEC_DELTA_BLOCK];
+        cvec_delta_decode_block(dv, lo - 1, values);
+        for (size_t j = 0; j < CVEC_DELTA_BLOCK; j++) {
+            if (values[j] >= value) {
+                return (lo - 1) * CVEC_DELTA_BLOCK + j;
+            }
+        }
+    }
+    if (lo < blocks) {
+        return lo * CVEC_DELTA_BLOCK;
+    }
+    for (size_t j = 0; j < dv->tail_size; j++) {
+        if (dv->tail[j] >= value) {
+            return blocks * CVEC_DELTA_BLOCK + j;
+        }
+    }
+    return cvec_delta_size(dv);
+}
+
+void cvec_delta_decompress_into(cvec_delta *dv, uint64_t **vec) {
+    const size_t blocks = cvec_uint64_t_size(&dv->index) / 2;
+    cvec_uint64_t_resize(vec, cvec_delta_size(dv));
+    uint64_t *out = cvec_uint64_t_data(vec);
+    for (size_t b = 0; b < blocks; b++) {
+        cvec_delta_decode_block(dv, b, out + b * CVEC_DELTA_BLOCK);
+    }
+    for (size_t j = 0; j < dv->tail_size; j++) {
+        out[blocks * CVEC_DELTA_BLOCK + j] = dv->tail[j];
+    }
+}
+
+//
+// Private functions
+//
+
+static void cvec_delta_encode(cvec_delta *dv) {
+    uint64_t deltas[CVEC_DELTA_BLOCK];
+    uint64_t words[CVEC_DELTA_BLOCK];
+    uint64_t all = 0;
+    deltas[0] = 0;
+    for (size_t j = 1; j < CVEC_DELTA_BLOCK; j++) {
+        deltas[j] = dv->tail[j] - dv->tail[j - 1];
+        all |= deltas[j];
+    }
+    unsigned bits = 0;
+    while (bits < 64 && (all >> bits) != 0) {
+        bits++;
+    }
+    // Value j goes to lane j % 2 at bit offset j / 2 * bits, lane words are interleaved
+    for (size_t k = 0; k < 2 * bits; k++) {
+        words[k] = 0;
+    }
+    for (size_t j = 0; bits && j < CVEC_DELTA_BLOCK; j++) {
+        const size_t lane = j & 1;
+        const size_t offset = (j >> 1) * bits;
+        const size_t k = offset >> 6;
+        const unsigned shift = offset & 63;
+        words[2 * k + lane] |= deltas[j] << shift;
+        if (shift + bits > 64) {
+            words[2 * k + 2 + lane] |= deltas[j] >> (64 - shift);
+        }
+    }
+    const uint64_t offset = cvec_uint64_t_size(&dv->words);
+    for (size_t k = 0; k < 2 * bits; k++) {
+        cvec_uint64_t_push_back(&dv->words, words[k]);
+    }
+    cvec_uint64_t_push_back(&dv->index, dv->tail[0]);
+    cvec_uint64_t_push_back(&dv->index, offset << 8 | bits);
+}
+
+static void cvec_delta_decode_block(cvec_delta *dv, size_t b, uint64_t *out) {
+    const uint64_t *index = cvec_uint64_t_data(&dv->index);
+    const uint64_t *words = cvec_uint64_t_data(&dv->words);
+    cvec_delta_decode(words + (index[b * 2 + 1] >> 8), index[b * 2 + 1] & 0xff, index[b * 2], out);
+}
+
+static void cvec_delta_decode(const uint64_t *words, unsigned bits, uint64_t base, uint64_t *out) {
+    if (bits == 0) {
+        for (size_t j = 0; j < CVEC_DELTA_BLOCK; j++) {
+            out[j] = base;
+        }
+        return;
+    }
+#ifdef __SSE2__
+    const __m128i mask = _mm_set1_epi64x(bits == 64 ? ~(uint64_t)0 : ((uint64_t)1 << bits) - 1);
+    __m128i carry = _mm_set1_epi64x(base);
+    for (size_t pos = 0; pos < CVEC_DELTA_BLOCK / 2; pos++) {
+        const size_t offset = pos * bits;
+        const size_t k = offset >> 6;
+        const unsigned shift = offset & 63;
+        // Unpack differences of the values 2 * pos and 2 * pos + 1
+        __m128i x = _mm_srl_epi64(_mm_loadu_si128((const __m128i *)&words[2 * k]),
+                                  _mm_cvtsi32_si128(shift));
+        if (shift + bits > 64) {
+            __m128i hi = _mm_loadu_si128((const __m128i *)&words[2 * k + 2]);
+            x = _mm_or_si128(x, _mm_sll_epi64(hi, _mm_cvtsi32_si128(64 - shift)));
+        }
+        x = _mm_and_si128(x, mask);
+        // Prefix sum: [d0, d1] -> [prev + d0, prev + d0 + d1]
+        x = _mm_add_epi64(x, _mm_slli_si128(x, 8));
+        x = _mm_add_epi64(x, carry);
+        _mm_storeu_si128((__m128i *)&out[2 * pos], x);
+        carry = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 2, 3, 2));
+    }
+#else
+    const uint64_t mask = bits == 64 ? ~(uint64_t)0 : ((uint64_t)1 << bits) - 1;
+    uint64_t value = base;
+    for (size_t j = 0; j < CVEC_DELTA_BLOCK; j++) {
+        const size_t lane = j & 1;
+        const size_t offset = (j >> 1) * bits;
+        const size_t k = offset >> 6;
+        const unsigned shift = offset & 63;
+        uint64_t delta = words[2 * k + lane] >> shift;
+        if (shift + bits > 64) {
+            delta |= words[2 * k + 2 + lane] << (64 - shift);
+        }
+        value += delta & mask;
+        out[j] = value;
+    }
+#endif
+}
+
+#endif
+
+#ifdef CVEC_DELTA_INST
+#   undef CVEC_DELTA_INST
+#endif
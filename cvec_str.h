@@ -0,0 +1,178 @@
+// Copyright (c) 2020 Magomed Kostoev
+//
+// You may use, distribute and modify this code under the terms of the MIT license.
+//
+// You should have received a copy of the MIT license with this file. If not, please visit
+// https://opensource.org/licenses/MIT for full license details.
+
+// cvec_str.h - string builder functions for vectors of char.
+//
+// A string is a regular cvec_char vector holding characters without the terminating zero, so
+// every cvec_char function works on it too. Appending functions copy whole blocks of memory into
+// the free space at the end of the vector, appendf prints into it directly and grows the vector
+// once if the output doesn't fit. cvec_str_c_str puts the terminating zero past the last
+// character (into the capacity, the size is not changed), so no extra push_back is needed.
+//
+// Configuration (definitions):
+// CVEC_STR_INST: Instantiate the functions if defined
+//
+// Minimal definitions for declaration: none
+// Minimal definitions for instantiation: CVEC_STR_INST
+//
+// Dependencies:
+// cvec.h instantiated for char and size_t somewhere in the program
+// <stdarg.h> or another source of va_list, va_start, va_copy and va_end
+// <stdio.h> or another source of vsnprintf
+// <string.h> or another source of memchr, memcmp, memcpy and strlen
+
+#ifndef CVEC_STR_DECLARED
+#define CVEC_STR_DECLARED
+
+#define CVEC_TYPE char
+#include "cvec.h"
+
+#define CVEC_TYPE size_t
+#include "cvec.h"
+
+/// Position returned by find functions if nothing is found
+#define CVEC_STR_NPOS SIZE_MAX
+
+/// Appends a zero-terminated string.
+void cvec_str_append_str(char **str, const char *s);
+
+/// Appends count bytes of memory.
+void cvec_str_append_mem(char **str, const void *mem, size_t count);
+
+/// Appends formatted output, returns count of appended characters (negative on format error).
+int cvec_str_appendf(char **str, const char *fmt, ...);
+
+/// Appends formatted output like cvec_str_appendf using the arguments list.
+int cvec_str_vappendf(char **str, const char *fmt, va_list args);
+
+/// Returns the zero-terminated contents of the string, valid until the string is changed.
+const char *cvec_str_c_str(char **str);
+
+/// Returns position of the first occurrence of c starting from pos (CVEC_STR_NPOS if none).
+size_t cvec_str_find_char(char **str, char c, size_t pos);
+
+/// Returns position of the first occurrence of needle starting from pos (CVEC_STR_NPOS if none).
+size_t cvec_str_find(char **str, const char *needle, size_t pos);
+
+/// Replaces the contents of fields by (offset, length) pair for each part of the string separated
+/// by sep, returns count of the parts (count of separators + 1).
+size_t cvec_str_split(char **str, char sep, size_t **fields);
+
+#endif
+
+#if defined(CVEC_STR_INST) && !defined(CVEC_STR_INSTANTIATED)
+#define CVEC_STR_INSTANTIATED
+
+void cvec_str_append_str(char **str, const char *s) {
+    cvec_str_append_mem(str, s, strlen(s));
+}
+
+void cvec_str_append_mem(char **str, const void *mem, size_t count) {
+    if (count) {
+        memcpy(cvec_char_extend(str, count), mem, count);
+    }
+}
+
+int cvec_str_appendf(char **str, const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    const int written = cvec_str_vappendf(str, fmt, args);
+    va_end(args);
+    return written;
+}
+
+int cvec_str_vappendf(char **str, const char *fmt, va_list args) {
+    va_list again;
+    va_copy(again, args);
+    // Print into the free space first, it's enough most of the time
+    const size_t size = cvec_char_size(str);
+    const size_t room = cvec_char_capacity(str) - size;
+    const int written = vsnprintf(room ? cvec_char_data(str) + size : NULL, room, fmt, args);
+    if (written >= 0 && (size_t)written < room) {
+        cvec_char_extend(str, written);
+    } else if (written >= 0) {
+        // Grow once and print again, the terminating zero is left in the capacity
+        const size_t length = (size_t)written + 1; // Can't overflow unlike written + 1 in int
+        vsnprintf(cvec_char_extend(str, length), length, fmt, again);
+        cvec_char_pop_back(str);
+    }
+    va_end(again);
+    return written;
+}
+
+const char *cvec_str_c_str(char **str) {
+    CVEC_ASSERT(str);
+    if (!*str) {
+        return "";
+    }
+    const size_t size = cvec_char_size(str);
+    if (cvec_char_capacity(str) == size) {
+        cvec_char_reserve(str, size + 1);
+    }
+    char *data = cvec_char_data(str);
+    data[size] = '\0';
+    return data;
+}
+
+size_t cvec_str_find_char(char **str, char c, size_t pos) {
+    const size_t size = cvec_char_size(str);
+    if (pos >= size) {
+        return CVEC_STR_NPOS;
+    }
+    const char *data = cvec_char_cbegin(str);
+    const char *found = memchr(data + pos, c, size - pos);
+    return found ? (size_t)(found - data) : CVEC_STR_NPOS;
+}
+
+size_t cvec_str_find(char **str, const char *needle, size_t pos) {
+    const size_t size = cvec_char_size(str);
+    const size_t len = strlen(needle);
+    if (pos > size || len > size - pos) {
+        return CVEC_STR_NPOS;
+    }
+    if (len == 0) {
+        return pos;
+    }
+    // Jump between occurrences of the first character by memchr, compare the rest by memcmp
+    const char *data = cvec_char_cbegin(str);
+    const char *last = data + size - len;
+    for (const char *it = data + pos; it <= last; it++) {
+        it = memchr(it, needle[0], last - it + 1);
+        if (!it) {
+            break;
+        }
+        if (memcmp(it + 1, needle + 1, len - 1) == 0) {
+            return it - data;
+        }
+    }
+    return CVEC_STR_NPOS;
+}
+
+size_t cvec_str_split(char **str, char sep, size_t **fields) {
+    const size_t size = cvec_char_size(str);
+    cvec_size_t_clear(fields);
+    size_t begin = 0;
+    for (;;) {
+        size_t end = cvec_str_find_char(str, sep, begin);
+        if (end == CVEC_STR_NPOS) {
+            end = size;
+        }
+        cvec_size_t_push_back(fields, begin);
+        cvec_size_t_push_back(fields, end - begin);
+        if (end == size) {
+            break;
+        }
+        begin = end + 1;
+    }
+    return cvec_size_t_size(fields) / 2;
+}
+
+#endif
+
+#ifdef CVEC_STR_INST
+#   undef CVEC_STR_INST
+#endif
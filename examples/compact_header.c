@@ -0,0 +1,101 @@
+//
+// The example program creates many small vectors as a per-key index does and prints memory held
+// by them with regular 16-byte headers and with CVEC_COMPACT 8-byte ones. Empty vectors are NULL
+// in both cases, so they take no memory at all.
+//
+// Usage: compact_header [count of vectors, 10M by default] [maximal size of each, 7 by default]
+//
+// More info in cvec.h
+//
+
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <malloc.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+typedef int plain_int;
+typedef int compact_int;
+
+#define CVEC_TYPE plain_int
+#define CVEC_INST
+#include "cvec.h"
+
+#define CVEC_TYPE compact_int
+#define CVEC_INST
+#define CVEC_COMPACT // Store size and capacity as 32-bit integers
+#include "cvec.h"
+
+// Sums bytes requested for the buffer and bytes taken by it from the heap (usable size and the
+// malloc chunk header)
+static void account(void *data, size_t header, size_t capacity, size_t *requested, size_t *heap) {
+	if (data) {
+		*requested += header + capacity * sizeof(int);
+		*heap += malloc_usable_size((char *)data - header) + sizeof(size_t);
+	}
+}
+
+static void report(const char *name, size_t count, size_t allocated, size_t requested, size_t heap) {
+	printf("%-8s %9zu buffers, requested %6.1f MB (%5.1f B/vector), heap %6.1f MB (%5.1f B/vector)\n",
+	       name, allocated, requested / 1e6, (double)requested / count, heap / 1e6,
+	       (double)heap / count);
+}
+
+int main(int argc, char **argv) {
+	size_t count = argc > 1 ? strtoull(argv[1], NULL, 0) : 10000000;
+	int max_size = argc > 2 ? atoi(argv[2]) : 7;
+	size_t allocated, requested, heap;
+
+	// Fill regular vectors by 0 to max_size elements each
+	plain_int **plain = malloc(count * sizeof(*plain));
+	srand(1);
+	for (size_t n = 0; n < count; n++) {
+		plain[n] = cvec_plain_int_new(0);
+		for (int size = rand() % (max_size + 1), i = 0; i < size; i++) {
+			cvec_plain_int_push_back(&plain[n], i);
+		}
+		cvec_plain_int_shrink_to_fit(&plain[n]);
+	}
+	allocated = requested = heap = 0;
+	for (size_t n = 0; n < count; n++) {
+		allocated += plain[n] != NULL;
+		account(plain[n], 2 * sizeof(size_t), cvec_plain_int_capacity(&plain[n]), &requested, &heap);
+	}
+	report("regular", count, allocated, requested, heap);
+	for (size_t n = 0; n < count; n++) {
+		cvec_plain_int_free(&plain[n]);
+	}
+	free(plain);
+
+	// Do the same with compact vectors
+	compact_int **compact = malloc(count * sizeof(*compact));
+	srand(1);
+	for (size_t n = 0; n < count; n++) {
+		compact[n] = cvec_compact_int_new(0);
+		for (int size = rand() % (max_size + 1), i = 0; i < size; i++) {
+			cvec_compact_int_push_back(&compact[n], i);
+		}
+		cvec_compact_int_shrink_to_fit(&compact[n]);
+	}
+	allocated = requested = heap = 0;
+	for (size_t n = 0; n < count; n++) {
+		allocated += compact[n] != NULL;
+		account(compact[n], 2 * sizeof(uint32_t), cvec_compact_int_capacity(&compact[n]), &requested,
+		        &heap);
+	}
+	report("compact", count, allocated, requested, heap);
+
+	// Empty vectors would take a whole malloc chunk for the header if they weren't NULL
+	void *header = malloc(2 * sizeof(size_t));
+	size_t chunk = malloc_usable_size(header) + sizeof(size_t);
+	free(header);
+	printf("%zu empty vectors own no buffer, saving %.1f MB of %zu-byte header chunks\n",
+	       count - allocated, (count - allocated) * chunk / 1e6, chunk);
+	for (size_t n = 0; n < count; n++) {
+		cvec_compact_int_free(&compact[n]);
+	}
+	free(compact);
+}
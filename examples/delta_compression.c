@@ -0,0 +1,89 @@
+//
+// The example program fills a plain vector and a compressed vector by the same sorted IDs and
+// prints memory used by each of them, scan and lookup speed.
+//
+// Usage: delta_compression [count of IDs, 64M by default] [maximal gap between IDs, 1000 by default]
+//
+// More info in cvec_delta.h
+//
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#define CVEC_TYPE uint64_t
+#define CVEC_INST
+#include "cvec.h"
+
+#define CVEC_DELTA_INST
+#include "cvec_delta.h"
+
+static double now_s(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv) {
+	size_t count = argc > 1 ? strtoull(argv[1], NULL, 0) : (size_t)64 << 20;
+	unsigned max_gap = argc > 2 ? strtoul(argv[2], NULL, 0) : 1000;
+
+	// Fill both vectors by the same IDs
+	uint64_t *plain = cvec_uint64_t_new(0);
+	cvec_delta dv;
+	cvec_delta_init(&dv);
+	uint64_t id = 0;
+	srand(1);
+	for (size_t i = 0; i < count; i++) {
+		id += 1 + rand() % max_gap;
+		cvec_uint64_t_push_back(&plain, id);
+		cvec_delta_push_back(&dv, id);
+	}
+	size_t plain_bytes = cvec_uint64_t_size(&plain) * sizeof(uint64_t);
+	size_t delta_bytes = cvec_delta_bytes(&dv);
+	printf("plain      %10zu bytes\n", plain_bytes);
+	printf("compressed %10zu bytes, ratio %.2f, %.2f bits per ID\n", delta_bytes,
+	       (double)plain_bytes / delta_bytes, delta_bytes * 8.0 / count);
+
+	// Scan the plain vector
+	double start = now_s();
+	uint64_t sum = 0;
+	for (size_t i = 0; i < count; i++) {
+		sum += plain[i];
+	}
+	double plain_time = now_s() - start;
+	printf("plain scan                   %8.1f M IDs/s (sum %lu)\n", count / plain_time / 1e6, sum);
+
+	// Decompress and scan the compressed vector (first decompression allocates the output)
+	uint64_t *out = cvec_uint64_t_new(0);
+	cvec_delta_decompress_into(&dv, &out);
+	start = now_s();
+	cvec_delta_decompress_into(&dv, &out);
+	double decompress_time = now_s() - start;
+	sum = 0;
+	for (size_t i = 0; i < count; i++) {
+		sum += out[i];
+	}
+	double scan_time = now_s() - start;
+	printf("compressed decompress_into   %8.1f M IDs/s\n", count / decompress_time / 1e6);
+	printf("compressed decompress + scan %8.1f M IDs/s (sum %lu)\n", count / scan_time / 1e6, sum);
+
+	// Look up random IDs
+	size_t lookups = 1 << 20;
+	start = now_s();
+	size_t found = 0;
+	for (size_t i = 0; i < lookups; i++) {
+		found += cvec_delta_lower_bound(&dv, plain[rand() % count]) < count;
+	}
+	printf("compressed lower_bound       %8.1f M lookups/s (found %zu)\n",
+	       lookups / (now_s() - start) / 1e6, found);
+
+	cvec_delta_free(&dv);
+	cvec_uint64_t_free(&plain);
+	cvec_uint64_t_free(&out);
+}
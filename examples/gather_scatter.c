@@ -0,0 +1,118 @@
+//
+// The example program gathers elements of a vector bigger than the last level cache by random
+// indices, scatters them back and permutes the vector, and prints speed of a scalar cvec_x_at
+// loop and of the batched functions for 4-byte and 8-byte elements.
+//
+// Build it with -O2 -mavx2 (or -march=native) to use AVX2 gather instructions.
+//
+// Usage: gather_scatter [count of elements, 64M by default] [count of indices, 16M by default]
+//
+// More info in cvec.h
+//
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+
+#define CVEC_TYPE uint32_t
+#define CVEC_INST
+#include "cvec.h"
+
+#define CVEC_TYPE uint64_t
+#define CVEC_INST
+#include "cvec.h"
+
+#define CVEC_TYPE size_t
+#define CVEC_INST
+#include "cvec.h"
+
+static double now_s(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static size_t random_index(size_t count) {
+	return ((size_t)rand() << 31 ^ (size_t)rand()) % count;
+}
+
+static void report(const char *name, size_t count, double time) {
+	printf("%-32s %8.1f M elements/s\n", name, count / time / 1e6);
+}
+
+// Runs the same workload for a vector of the given type
+#define BENCHMARK(T) do { \
+	T *vec = cvec_##T##_new(count); \
+	for (size_t i = 0; i < count; i++) { \
+		cvec_##T##_push_back(&vec, i); \
+	} \
+	T *out = malloc(lookups * sizeof(*out)); \
+	uint64_t sum = 0; \
+	\
+	double start = now_s(); \
+	for (size_t i = 0; i < lookups; i++) { \
+		out[i] = cvec_##T##_at(&vec, idx[i]); \
+	} \
+	report(#T " at loop", lookups, now_s() - start); \
+	\
+	start = now_s(); \
+	cvec_##T##_gather(out, &vec, idx, lookups); \
+	report(#T " gather", lookups, now_s() - start); \
+	\
+	start = now_s(); \
+	for (size_t i = 0; i < lookups; i++) { \
+		vec[idx[i]] = out[i]; \
+	} \
+	report(#T " scatter loop", lookups, now_s() - start); \
+	\
+	start = now_s(); \
+	cvec_##T##_scatter(&vec, out, idx, lookups); \
+	report(#T " scatter", lookups, now_s() - start); \
+	\
+	start = now_s(); \
+	cvec_##T##_permute(&vec, perm); \
+	report(#T " permute", count, now_s() - start); \
+	\
+	start = now_s(); \
+	cvec_##T##_apply_permutation(&vec, perm); \
+	report(#T " apply_permutation", count, now_s() - start); \
+	\
+	for (size_t i = 0; i < lookups; i++) { \
+		sum += out[i]; \
+	} \
+	printf("(sum %lu)\n", sum); \
+	free(out); \
+	cvec_##T##_free(&vec); \
+} while (0)
+
+int main(int argc, char **argv) {
+	size_t count = argc > 1 ? strtoull(argv[1], NULL, 0) : (size_t)64 << 20;
+	size_t lookups = argc > 2 ? strtoull(argv[2], NULL, 0) : (size_t)16 << 20;
+
+	// Random indices and a random permutation (Fisher-Yates shuffle)
+	srand(1);
+	size_t *idx = cvec_size_t_new(lookups);
+	for (size_t i = 0; i < lookups; i++) {
+		cvec_size_t_push_back(&idx, random_index(count));
+	}
+	size_t *perm = cvec_size_t_new(count);
+	for (size_t i = 0; i < count; i++) {
+		cvec_size_t_push_back(&perm, i);
+	}
+	for (size_t i = count - 1; i > 0; i--) {
+		size_t j = random_index(i + 1), tmp = perm[i];
+		perm[i] = perm[j];
+		perm[j] = tmp;
+	}
+
+	BENCHMARK(uint32_t);
+	BENCHMARK(uint64_t);
+
+	cvec_size_t_free(&idx);
+	cvec_size_t_free(&perm);
+}
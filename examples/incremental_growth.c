@@ -0,0 +1,117 @@
+//
+// The example program measures latency of each push_back into a huge vector and prints its
+// percentiles for a regular vector, for a regular vector whose CVEC_REALLOC always copies (malloc,
+// memcpy and free) and for a vector with CVEC_INCREMENTAL defined. The copying one copies all the
+// elements each time it gets out of space, so its tail latency grows with its size. The
+// incremental one moves a few elements on each push_back instead. The plain regular vector is
+// only as good as the allocator's realloc: glibc moves big blocks by mremap without copying them,
+// so it doesn't pay for the copy there.
+//
+// Usage: incremental_growth [count of elements, 16M by default]
+//
+// More info in cvec.h
+//
+
+#define _DEFAULT_SOURCE // For clock_gettime and madvise (CVEC_DISCARD)
+
+#include <assert.h>
+#include <malloc.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+typedef uint64_t plain_u64;
+typedef uint64_t copy_u64;
+typedef uint64_t incr_u64;
+
+// Reallocates the way allocators without in-place or remapping growth do
+static void *copying_realloc(void *ptr, size_t size) {
+	void *new_ptr = malloc(size);
+	if (new_ptr && ptr) {
+		const size_t old_size = malloc_usable_size(ptr);
+		memcpy(new_ptr, ptr, old_size < size ? old_size : size);
+	}
+	if (new_ptr) {
+		free(ptr);
+	}
+	return new_ptr;
+}
+
+#define CVEC_TYPE plain_u64
+#define CVEC_INST
+#include "cvec.h"
+
+#define CVEC_TYPE copy_u64
+#define CVEC_INST
+#define CVEC_REALLOC copying_realloc // Copy the whole buffer on each expansion
+#include "cvec.h"
+
+#define CVEC_TYPE incr_u64
+#define CVEC_INST
+#define CVEC_INCREMENTAL // Don't copy the whole buffer on expansion
+#include "cvec.h"
+
+static uint64_t now_ns(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static int compare_u64(const void *a, const void *b) {
+	uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+	return (x > y) - (x < y);
+}
+
+static void report(const char *name, uint64_t *latencies, size_t count, uint64_t total) {
+	qsort(latencies, count, sizeof(*latencies), compare_u64);
+	printf("%-12s total %8.1f ms, p50 %6lu ns, p99 %6lu ns, p99.9 %8lu ns, max %10lu ns\n", name,
+	       total / 1e6, latencies[count / 2], latencies[count / 100 * 99],
+	       latencies[count / 1000 * 999], latencies[count - 1]);
+}
+
+int main(int argc, char **argv) {
+	size_t count = argc > 1 ? strtoull(argv[1], NULL, 0) : (size_t)16 << 20;
+	uint64_t *latencies = malloc(count * sizeof(*latencies));
+
+	// Fill a regular vector timing each push_back
+	plain_u64 *plain = cvec_plain_u64_new(0);
+	uint64_t start = now_ns();
+	for (size_t i = 0; i < count; i++) {
+		uint64_t t = now_ns();
+		cvec_plain_u64_push_back(&plain, i);
+		latencies[i] = now_ns() - t;
+	}
+	report("regular", latencies, count, now_ns() - start);
+	cvec_plain_u64_free(&plain);
+
+	// Fill a regular vector copying the elements on expansion
+	copy_u64 *copy = cvec_copy_u64_new(0);
+	start = now_ns();
+	for (size_t i = 0; i < count; i++) {
+		uint64_t t = now_ns();
+		cvec_copy_u64_push_back(&copy, i);
+		latencies[i] = now_ns() - t;
+	}
+	report("copying", latencies, count, now_ns() - start);
+	cvec_copy_u64_free(&copy);
+
+	// Fill an incremental vector the same way
+	incr_u64 *incr = cvec_incr_u64_new(0);
+	start = now_ns();
+	for (size_t i = 0; i < count; i++) {
+		uint64_t t = now_ns();
+		cvec_incr_u64_push_back(&incr, i);
+		latencies[i] = now_ns() - t;
+	}
+	report("incremental", latencies, count, now_ns() - start);
+
+	// Check the elements are in place
+	for (size_t i = 0; i < count; i++) {
+		assert(cvec_incr_u64_at(&incr, i) == i);
+	}
+	cvec_incr_u64_free(&incr);
+	free(latencies);
+}
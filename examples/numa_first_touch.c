@@ -0,0 +1,138 @@
+//
+// The example program fills a huge vector by a single thread and by cvec_x_resize_parallel, sums
+// it by the same count of threads each reading its own part, and prints time spent and count of
+// pages placed on each NUMA node. Both the filling and the reading threads are pinned to the CPUs
+// round-robin, so the parallel fill places each part on the node of the thread reading it later,
+// while the single thread puts all the pages on its own node.
+//
+// Usage: numa_first_touch [count of elements, 128M by default] [count of threads, one per CPU by
+//                         default] [policy: default, local, interleave or bind, default by default]
+//                         [node mask for interleave and bind, 1 by default]
+//
+// More info in cvec.h
+//
+
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#define CVEC_TYPE uint64_t
+#define CVEC_INST
+#define CVEC_NUMA // Apply the NUMA policy and add the parallel first-touch functions
+#define CVEC_GLOBAL_INST // Instantiate the NUMA policy itself
+#include "cvec.h"
+
+struct part {
+	const uint64_t *first;
+	size_t count;
+	uint64_t sum;
+	int cpu;
+};
+
+static double now_s(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *sum_part(void *arg) {
+	struct part *part = arg;
+	cpu_set_t cpus;
+	CPU_ZERO(&cpus);
+	CPU_SET(part->cpu, &cpus);
+	pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+	for (size_t i = 0; i < part->count; i++) {
+		part->sum += part->first[i];
+	}
+	return NULL;
+}
+
+// Sums the vector by threads reading the same parts cvec_x_resize_parallel sets on the same CPUs
+static uint64_t parallel_sum(uint64_t **vec, unsigned threads) {
+	size_t count = cvec_uint64_t_size(vec);
+	struct part parts[threads];
+	pthread_t ids[threads];
+	cpu_set_t allowed;
+	pthread_getaffinity_np(pthread_self(), sizeof(allowed), &allowed);
+	int cpu = -1;
+	for (unsigned t = 0; t < threads; t++) {
+		size_t begin = count / threads * t + (t < count % threads ? t : count % threads);
+		do {
+			cpu = (cpu + 1) % CPU_SETSIZE;
+		} while (!CPU_ISSET(cpu, &allowed));
+		parts[t] = (struct part){ *vec + begin, count / threads + (t < count % threads), 0, cpu };
+		pthread_create(&ids[t], NULL, sum_part, &parts[t]);
+	}
+	uint64_t sum = 0;
+	for (unsigned t = 0; t < threads; t++) {
+		pthread_join(ids[t], NULL);
+		sum += parts[t].sum;
+	}
+	return sum;
+}
+
+// Prints count of sampled pages on each node (MPOL_F_NODE | MPOL_F_ADDR returns node of the page)
+static void print_nodes(uint64_t **vec) {
+	size_t nodes[64] = { 0 };
+	const size_t page = sysconf(_SC_PAGESIZE);
+	const char *data = (const char *)*vec;
+	const size_t bytes = cvec_uint64_t_size(vec) * sizeof(uint64_t);
+	for (size_t offset = 0; offset < bytes; offset += page * 256) {
+		int node = -1;
+		if (syscall(SYS_get_mempolicy, &node, NULL, 0, data + offset, 3) != 0 || node < 0 || node >= 64) {
+			printf("  placement is unknown (no NUMA support)\n");
+			return;
+		}
+		nodes[node]++;
+	}
+	for (int node = 0; node < 64; node++) {
+		if (nodes[node]) {
+			printf("  node %d: %zu sampled pages\n", node, nodes[node]);
+		}
+	}
+}
+
+int main(int argc, char **argv) {
+	size_t count = argc > 1 ? strtoull(argv[1], NULL, 0) : (size_t)128 << 20;
+	unsigned threads = argc > 2 && atoi(argv[2]) > 0 ? (unsigned)atoi(argv[2]) : cvec_numa_cpus();
+	const char *policies[] = { "default", "local", "interleave", "bind" };
+	unsigned long nodes = argc > 4 ? strtoul(argv[4], NULL, 0) : 1;
+	for (int policy = 0; argc > 3 && policy < 4; policy++) {
+		if (strcmp(argv[3], policies[policy]) == 0 && cvec_numa_set_policy(policy, nodes) != 0) {
+			printf("%s policy is not supported, using the default one\n", policies[policy]);
+		}
+	}
+	printf("%zu elements, %u threads, %s policy\n", count, threads, policies[cvec_numa_policy()]);
+
+	// Fill the vector by a single thread
+	uint64_t *vec = NULL;
+	double start = now_s();
+	cvec_uint64_t_resize_v(&vec, count, 1);
+	double fill_time = now_s() - start;
+	start = now_s();
+	uint64_t sum = parallel_sum(&vec, threads);
+	printf("resize_v          fill %7.1f ms, parallel sum %7.1f ms (sum %lu)\n", fill_time * 1e3,
+	       (now_s() - start) * 1e3, sum);
+	print_nodes(&vec);
+	cvec_uint64_t_free(&vec);
+
+	// Fill it by the threads summing it later
+	start = now_s();
+	cvec_uint64_t_resize_parallel(&vec, count, 1, threads);
+	fill_time = now_s() - start;
+	start = now_s();
+	sum = parallel_sum(&vec, threads);
+	printf("resize_parallel   fill %7.1f ms, parallel sum %7.1f ms (sum %lu)\n", fill_time * 1e3,
+	       (now_s() - start) * 1e3, sum);
+	print_nodes(&vec);
+	cvec_uint64_t_free(&vec);
+}
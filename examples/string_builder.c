@@ -0,0 +1,105 @@
+//
+// The example program builds a log of many lines the way examples/exponential_growing.c builds
+// its line (a push_back for each character and a zero pushed by hand) and by cvec_str.h functions,
+// and prints time spent by each way.
+//
+// Usage: string_builder [count of lines, 10M by default]
+//
+// More info in cvec_str.h
+//
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <assert.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#define CVEC_TYPE char
+#define CVEC_INST
+#include "cvec.h"
+
+#define CVEC_TYPE size_t
+#define CVEC_INST
+#include "cvec.h"
+
+#define CVEC_STR_INST
+#include "cvec_str.h"
+
+static const char *levels[] = { "debug", "info", "warning", "error" };
+
+static double now_s(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void report(const char *name, size_t count, double time, char **log) {
+	printf("%-22s %6.1f ns per line, %zu bytes\n", name, time / count * 1e9, strlen(*log));
+}
+
+int main(int argc, char **argv) {
+	size_t count = argc > 1 ? strtoull(argv[1], NULL, 0) : 10000000;
+	const char *message = "request served";
+
+	// Format each line into a buffer and copy it character by character
+	char *log = cvec_char_new(0);
+	double start = now_s();
+	for (size_t i = 0; i < count; i++) {
+		char line[128];
+		int length = snprintf(line, sizeof(line), "[%zu] %s: %s\n", i, levels[i % 4], message);
+		for (int j = 0; j < length; j++) {
+			cvec_char_push_back(&log, line[j]);
+		}
+	}
+	cvec_char_push_back(&log, '\0');
+	report("push_back per char", count, now_s() - start, &log);
+	cvec_char_free(&log);
+
+	// Format each line into a buffer and append it at once
+	start = now_s();
+	for (size_t i = 0; i < count; i++) {
+		char line[128];
+		int length = snprintf(line, sizeof(line), "[%zu] %s: %s\n", i, levels[i % 4], message);
+		cvec_str_append_mem(&log, line, length);
+	}
+	cvec_str_c_str(&log);
+	report("append_mem", count, now_s() - start, &log);
+	cvec_char_free(&log);
+
+	// Append the parts of each line without formatting the words
+	start = now_s();
+	for (size_t i = 0; i < count; i++) {
+		char number[32];
+		snprintf(number, sizeof(number), "[%zu] ", i);
+		cvec_str_append_str(&log, number);
+		cvec_str_append_str(&log, levels[i % 4]);
+		cvec_str_append_mem(&log, ": ", 2);
+		cvec_str_append_str(&log, message);
+		cvec_str_append_mem(&log, "\n", 1);
+	}
+	cvec_str_c_str(&log);
+	report("append_str by parts", count, now_s() - start, &log);
+	cvec_char_free(&log);
+
+	// Print each line right into the string
+	start = now_s();
+	for (size_t i = 0; i < count; i++) {
+		cvec_str_appendf(&log, "[%zu] %s: %s\n", i, levels[i % 4], message);
+	}
+	cvec_str_c_str(&log);
+	report("appendf", count, now_s() - start, &log);
+
+	// Split the log into lines
+	size_t *lines = NULL;
+	start = now_s();
+	size_t parts = cvec_str_split(&log, '\n', &lines);
+	printf("%-22s %6.1f ns per line, %zu lines\n", "split", (now_s() - start) / count * 1e9, parts - 1);
+
+	cvec_size_t_free(&lines);
+	cvec_char_free(&log);
+}
@@ -1,13 +1,94 @@
 #include <assert.h>
+#include <pthread.h>
+#include <stdarg.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #define CVEC_TYPE int
 #define CVEC_INST
 #include "cvec.h"
 
+typedef int cowint;
+
+#define CVEC_TYPE cowint
+#define CVEC_INST
+#define CVEC_COW
+#include "cvec.h"
+
+typedef int shrinkint;
+
+// Count of buffers freed by the process-wide part (cvec_cache_flush) and by shrinkint vectors
+static size_t global_frees;
+
+static void counting_free(void *ptr) {
+	__atomic_add_fetch(&global_frees, 1, __ATOMIC_RELAXED);
+	free(ptr);
+}
+
+#define CVEC_TYPE shrinkint
+#define CVEC_INST
+#define CVEC_SHRINK
+#define CVEC_BUDGET
+#define CVEC_GLOBAL_INST
+#define CVEC_FREE counting_free
+#include "cvec.h"
+
+typedef int incrint;
+
+#define CVEC_TYPE incrint
+#define CVEC_INST
+#define CVEC_INCREMENTAL
+#define CVEC_INCREMENTAL_MIN 0
+#define CVEC_INCREMENTAL_STEP 1
+#include "cvec.h"
+
+#define CVEC_TYPE uint64_t
+#define CVEC_INST
+#include "cvec.h"
+
+#define CVEC_DELTA_INST
+#include "cvec_delta.h"
+
+typedef int cacheint;
+
+#define CVEC_TYPE cacheint
+#define CVEC_INST
+#define CVEC_CACHE
+#include "cvec.h"
+
+typedef int compactint;
+
+#define CVEC_TYPE compactint
+#define CVEC_INST
+#define CVEC_COMPACT
+#include "cvec.h"
+
+#define CVEC_TYPE size_t
+#define CVEC_INST
+#include "cvec.h"
+
+#define CVEC_TYPE int
+#define CVEC_INST
+#include "cvec_csr.h"
+
+typedef int numaint;
+
+#define CVEC_TYPE numaint
+#define CVEC_INST
+#define CVEC_NUMA
+#define CVEC_NUMA_MIN 4096
+#include "cvec.h"
+
+#define CVEC_TYPE char
+#define CVEC_INST
+#include "cvec.h"
+
+#define CVEC_STR_INST
+#include "cvec_str.h"
+
 #define check(cond) do { \
 	if (!(cond)) { \
 		fprintf(stderr, "Check failed at %s:%d\n", __FILE__, __LINE__); \
@@ -101,9 +182,578 @@ void check_pop_front(size_t vector_size) {
 	fprintf(stderr, "OK\n");
 }
 
+void check_cow(size_t vector_size) {
+	fprintf(stderr, "%s(%lu): ", __func__, vector_size);
+
+	// Create and fill a copy-on-write vector
+	cowint *a = cvec_cowint_new(0);
+	for (int i = 0; i < vector_size; i++) {
+		cvec_cowint_push_back(&a, i);
+	}
+	check(cvec_cowint_use_count(&a) == 1);
+
+	// Share it, the buffer should be the same
+	cowint *b = cvec_cowint_share(&a);
+	cowint *c = NULL;
+	cvec_cowint_assign_other(&c, &a);
+	check(b == a && c == a);
+	check(cvec_cowint_use_count(&a) == 3);
+
+	// Modify the shared vectors, they should detach
+	cvec_cowint_set(&b, 0, -1);
+	check(b != a);
+	check(cvec_cowint_use_count(&a) == 2);
+	check(cvec_cowint_use_count(&b) == 1);
+	cvec_cowint_push_back(&c, -2);
+	check(c != a);
+	check(cvec_cowint_use_count(&a) == 1);
+
+	// Check em all
+	check(cvec_cowint_size(&a) == vector_size);
+	check(cvec_cowint_size(&b) == vector_size);
+	check(cvec_cowint_size(&c) == vector_size + 1);
+	for (int i = 0; i < vector_size; i++) {
+		check(a[i] == i);
+		check(b[i] == (i == 0 ? -1 : i));
+		check(c[i] == i);
+	}
+	check(c[vector_size] == -2);
+
+	// The last owner can modify the buffer in place
+	cowint *a_data = a;
+	cvec_cowint_pop_back(&a);
+	check(a == a_data);
+
+	// Clearing or reassigning a shared vector copies nothing, it just drops the reference
+	cvec_cowint_free(&b);
+	b = cvec_cowint_share(&a);
+	cvec_cowint_clear(&b);
+	check(b == NULL && cvec_cowint_use_count(&a) == 1);
+	b = cvec_cowint_share(&a);
+	cvec_cowint_assign_fill(&b, 3, 7);
+	check(b != a && cvec_cowint_use_count(&a) == 1);
+	check(cvec_cowint_size(&b) == 3 && cvec_cowint_capacity(&b) == 3 && b[2] == 7);
+	check(cvec_cowint_size(&a) == vector_size - 1 && a[0] == 0);
+
+	// Appending to an empty vector sharing a buffer with capacity detaches it
+	cvec_cowint_free(&b);
+	cvec_cowint_reserve(&b, vector_size);
+	cowint *d = cvec_cowint_share(&b);
+	cvec_cowint_push_back(&d, 1);
+	*cvec_cowint_extend(&b, 1) = 2;
+	check(d != b && d[0] == 1 && b[0] == 2);
+	check(cvec_cowint_use_count(&b) == 1 && cvec_cowint_use_count(&d) == 1);
+	cvec_cowint_free(&d);
+
+	cvec_cowint_free(&a);
+	cvec_cowint_free(&b);
+	cvec_cowint_free(&c);
+
+	fprintf(stderr, "OK\n");
+}
+
+void check_shrink(size_t vector_size) {
+	fprintf(stderr, "%s(%lu): ", __func__, vector_size);
+
+	// Create and fill a vector
+	shrinkint *ints = cvec_shrinkint_new(0);
+	for (int i = 0; i < vector_size; i++) {
+		cvec_shrinkint_push_back(&ints, i);
+	}
+	check(cvec_budget_used() > vector_size * sizeof(int));
+
+	// Pop back all elements, the capacity should follow the size with hysteresis
+	for (int i = vector_size - 1; i >= 0; i--) {
+		check(cvec_shrinkint_pop_back(&ints) == i);
+		size_t size = cvec_shrinkint_size(&ints);
+		size_t cap = cvec_shrinkint_capacity(&ints);
+		check(size < 16 || size >= cap / 4);
+		check(cap >= size);
+		check(cvec_shrinkint_back(&ints) == i - 1 || size == 0);
+	}
+	check(cvec_shrinkint_capacity(&ints) >= 16);
+
+	// Churn at the boundary should not reallocate
+	cvec_shrinkint_resize(&ints, vector_size);
+	while (cvec_shrinkint_size(&ints) >= cvec_shrinkint_capacity(&ints) / 4) {
+		cvec_shrinkint_pop_back(&ints);
+	}
+	shrinkint *data = ints;
+	for (int i = 0; i < 100; i++) {
+		cvec_shrinkint_push_back(&ints, i);
+		cvec_shrinkint_pop_back(&ints);
+	}
+	check(ints == data);
+
+	// Exceed the budget, removals should trim the free space at the shrink threshold
+	cvec_shrinkint_resize(&ints, vector_size);
+	cvec_shrinkint_push_back(&ints, 0);
+	size_t cap = cvec_shrinkint_capacity(&ints);
+	check(cap > vector_size);
+	cvec_budget_set_limit(1);
+	cvec_shrinkint_pop_back(&ints);
+	check(cvec_shrinkint_capacity(&ints) == cap);
+	while (cvec_shrinkint_size(&ints) > cap / 4) {
+		cvec_shrinkint_pop_back(&ints);
+	}
+	check(cvec_shrinkint_capacity(&ints) == cvec_shrinkint_size(&ints) * 2);
+
+	// Churn under the budget pressure should not reallocate either
+	data = ints;
+	for (int i = 0; i < 100; i++) {
+		cvec_shrinkint_push_back(&ints, i);
+		cvec_shrinkint_pop_back(&ints);
+	}
+	check(ints == data);
+	cvec_budget_set_limit(0);
+
+	cvec_shrinkint_free(&ints);
+	check(cvec_budget_used() == 0);
+
+	fprintf(stderr, "OK\n");
+}
+
+void check_incremental(size_t vector_size) {
+	fprintf(stderr, "%s(%lu): ", __func__, vector_size);
+
+	// Create and fill a vector checking all the elements each push_back
+	incrint *ints = cvec_incrint_new(0);
+	int migrating = 0;
+	for (int i = 0; i < vector_size; i++) {
+		cvec_incrint_push_back(&ints, i);
+		migrating |= cvec_incrint_migrate(&ints, 0) != 0;
+		for (int j = 0; j <= i; j++) {
+			check(cvec_incrint_at(&ints, j) == j);
+		}
+	}
+	check(migrating);
+
+	// Modify and remove elements during migration
+	cvec_incrint_reserve(&ints, vector_size * 2);
+	check(cvec_incrint_migrate(&ints, 0) == vector_size);
+	cvec_incrint_set(&ints, vector_size - 1, -1);
+	check(cvec_incrint_back(&ints) == -1);
+	check(cvec_incrint_pop_back(&ints) == -1);
+	check(cvec_incrint_migrate(&ints, 0) == vector_size - 3); // Each operation moved an element
+
+	// Get the buffer, all the elements should be moved into it
+	incrint *data = cvec_incrint_data(&ints);
+	check(cvec_incrint_migrate(&ints, 0) == 0);
+	check(cvec_incrint_size(&ints) == vector_size - 1);
+	for (int i = 0; i < vector_size - 1; i++) {
+		check(data[i] == i);
+	}
+
+	// Reassign the vector during migration
+	cvec_incrint_reserve(&ints, vector_size * 4);
+	cvec_incrint_assign_fill(&ints, 10, 7);
+	check(cvec_incrint_migrate(&ints, 0) == 0);
+	check(cvec_incrint_size(&ints) == 10);
+	for (int i = 0; i < 10; i++) {
+		check(ints[i] == 7);
+	}
+
+	// Pop front right after an expansion, nothing is moved yet
+	cvec_incrint_clear(&ints);
+	for (int i = 1; i <= 100; i++) {
+		cvec_incrint_push_back(&ints, i);
+	}
+	cvec_incrint_reserve(&ints, vector_size * 8);
+	check(cvec_incrint_migrate(&ints, 0) == 100);
+	check(cvec_incrint_pop_front(&ints) == 1);
+	check(cvec_incrint_front(&ints) == 2);
+
+	// Fill a vector big enough to give the old buffers back by chunks during migration
+	cvec_incrint_clear(&ints);
+	for (int i = 0; i < vector_size * 1000; i++) {
+		cvec_incrint_push_back(&ints, i);
+		if (i % 997 == 0) {
+			check(cvec_incrint_at(&ints, i / 2) == i / 2);
+		}
+	}
+	for (int i = 0; i < vector_size * 1000; i++) {
+		check(cvec_incrint_at(&ints, i) == i);
+	}
+
+	cvec_incrint_free(&ints);
+
+	fprintf(stderr, "OK\n");
+}
+
+void check_delta(size_t vector_size) {
+	fprintf(stderr, "%s(%lu): ", __func__, vector_size);
+
+	// Fill a compressed vector with gaps of different widths including the full 64-bit one
+	uint64_t *values = cvec_uint64_t_new(0);
+	cvec_delta dv;
+	cvec_delta_init(&dv);
+	uint64_t value = 0;
+	for (size_t i = 0; i < vector_size; i++) {
+		size_t block = i / CVEC_DELTA_BLOCK;
+		if (i == vector_size / 2) {
+			value = UINT64_MAX - vector_size;
+		} else if (i > vector_size / 2 || block % 3 == 1) {
+			value += i % 3;
+		} else if (block % 3 == 2) {
+			value += i * 7919;
+		}
+		cvec_uint64_t_push_back(&values, value);
+		cvec_delta_push_back(&dv, value);
+	}
+	check(cvec_delta_size(&dv) == vector_size);
+
+	// Check em all
+	for (size_t i = 0; i < vector_size; i++) {
+		check(cvec_delta_at(&dv, i) == values[i]);
+	}
+	uint64_t *out = cvec_uint64_t_new(0);
+	cvec_delta_decompress_into(&dv, &out);
+	check(cvec_uint64_t_size(&out) == vector_size);
+	for (size_t i = 0; i < vector_size; i++) {
+		check(out[i] == values[i]);
+	}
+
+	// Check lower_bound against linear search
+	for (size_t i = 0; i < vector_size; i++) {
+		for (int d = -1; d <= 1; d++) {
+			uint64_t x = values[i] + d;
+			size_t expected = 0;
+			while (expected < vector_size && values[expected] < x) {
+				expected++;
+			}
+			check(cvec_delta_lower_bound(&dv, x) == expected);
+		}
+	}
+
+	cvec_delta_free(&dv);
+	cvec_uint64_t_free(&values);
+	cvec_uint64_t_free(&out);
+
+	fprintf(stderr, "OK\n");
+}
+
+void check_csr(size_t row_count) {
+	fprintf(stderr, "%s(%lu): ", __func__, row_count);
+
+	// Create rows of different sizes as separate vectors
+	int **rows = malloc(row_count * sizeof(*rows));
+	for (int r = 0; r < row_count; r++) {
+		rows[r] = cvec_int_new(0);
+		for (int i = 0; i < r % 7; i++) {
+			cvec_int_push_back(&rows[r], r * 10 + i);
+		}
+	}
+
+	// Pack them, then add the same rows using append_row and push_back
+	cvec_csr_int csr;
+	cvec_csr_int_init(&csr);
+	cvec_csr_int_pack(&csr, rows, row_count);
+	check(cvec_csr_int_rows(&csr) == row_count);
+	size_t reallocations = 0;
+	for (int r = 0; r < row_count; r++) {
+		size_t capacity = cvec_int_capacity(&csr.values);
+		int *row = cvec_csr_int_append_row(&csr, rows[r], cvec_int_size(&rows[r]));
+		check(row == cvec_csr_int_row_begin(&csr, row_count + r));
+		reallocations += cvec_int_capacity(&csr.values) != capacity;
+	}
+	check(reallocations < 10); // The values grow geometrically
+	for (int r = 0; r < row_count; r++) {
+		for (int i = 0; i < r % 7; i++) {
+			cvec_csr_int_push_back(&csr, r * 10 + i);
+		}
+		cvec_csr_int_end_row(&csr);
+	}
+	check(cvec_csr_int_rows(&csr) == row_count * 3);
+
+	// Check em all
+	size_t total = 0;
+	for (int r = 0; r < row_count * 3; r++) {
+		int *row = cvec_csr_int_row_begin(&csr, r);
+		size_t size = cvec_csr_int_row_size(&csr, r);
+		check(size == (r % row_count) % 7);
+		check(cvec_csr_int_row_end(&csr, r) == row + size);
+		for (int i = 0; i < size; i++) {
+			check(row[i] == (r % row_count) * 10 + i);
+		}
+		total += size;
+	}
+	check(cvec_csr_int_size(&csr) == total);
+
+	for (int r = 0; r < row_count; r++) {
+		cvec_int_free(&rows[r]);
+	}
+	free(rows);
+	cvec_csr_int_free(&csr);
+
+	fprintf(stderr, "OK\n");
+}
+
+// Fills the cache of a new thread, the thread exits without flushing it
+void *fill_cache(void *vector_size) {
+	for (int n = 0; n < 10; n++) {
+		cacheint *ints = cvec_cacheint_new(0);
+		for (size_t i = 0; i < *(size_t *)vector_size; i++) {
+			cvec_cacheint_push_back(&ints, i);
+		}
+		cvec_cacheint_free(&ints);
+	}
+	struct cvec_cache_stats stats;
+	cvec_cache_get_stats(&stats);
+	return (void *)(stats.puts - stats.hits); // Count of buffers left in the cache
+}
+
+void check_cache(size_t vector_size) {
+	fprintf(stderr, "%s(%lu): ", __func__, vector_size);
+
+	struct cvec_cache_stats before, after;
+	cvec_cache_get_stats(&before);
+
+	// Create, fill and free vectors, the buffers should be recycled
+	for (int n = 0; n < 10; n++) {
+		cacheint *ints = cvec_cacheint_new(0);
+		for (int i = 0; i < vector_size; i++) {
+			cvec_cacheint_push_back(&ints, i);
+		}
+		check(cvec_cacheint_size(&ints) == vector_size);
+		check(cvec_cacheint_capacity(&ints) >= vector_size);
+		for (int i = 0; i < vector_size; i++) {
+			check(ints[i] == i);
+		}
+		cvec_cacheint_shrink_to_fit(&ints);
+		for (int i = 0; i < vector_size; i++) {
+			check(ints[i] == i);
+		}
+		cvec_cacheint_free(&ints);
+	}
+	cvec_cache_get_stats(&after);
+	check(after.hits > before.hits);
+	check(after.puts > before.puts);
+	check(after.bytes > 0 && after.bytes <= (1 << 20));
+
+	// Free the cached buffers
+	cvec_cache_flush();
+	cvec_cache_get_stats(&after);
+	check(after.bytes == 0);
+
+	// Buffers cached by a thread are freed by cvec_cache_flush when it exits
+	pthread_t thread;
+	void *cached = NULL;
+	const size_t frees = global_frees;
+	check(pthread_create(&thread, NULL, fill_cache, &vector_size) == 0);
+	check(pthread_join(thread, &cached) == 0);
+	check(cached != NULL);
+	check(global_frees - frees == (size_t)cached);
+
+	fprintf(stderr, "OK\n");
+}
+
+void check_compact(size_t vector_size) {
+	fprintf(stderr, "%s(%lu): ", __func__, vector_size);
+
+	// An empty vector is NULL and owns no buffer
+	compactint *ints = cvec_compactint_new(0);
+	check(ints == NULL);
+	check(cvec_compactint_size(&ints) == 0);
+	check(cvec_compactint_capacity(&ints) == 0);
+
+	// It gets a buffer on the first push_back
+	for (int i = 0; i < vector_size; i++) {
+		cvec_compactint_push_back(&ints, i);
+	}
+	check(cvec_compactint_size(&ints) == vector_size);
+	check(cvec_compactint_capacity(&ints) >= vector_size);
+	for (int i = 0; i < vector_size; i++) {
+		check(ints[i] == i);
+	}
+	check(cvec_compactint_max_size(&ints) == UINT32_MAX);
+
+	// Pop back all elements, shrink_to_fit of the empty vector frees its buffer
+	for (int i = vector_size - 1; i >= 0; i--) {
+		check(cvec_compactint_pop_back(&ints) == i);
+	}
+	cvec_compactint_shrink_to_fit(&ints);
+	check(ints == NULL);
+
+	// Regular vectors behave the same way
+	int *regular = cvec_int_new(0);
+	check(regular == NULL);
+	cvec_int_reserve(&regular, vector_size);
+	check(cvec_int_capacity(&regular) == vector_size);
+	cvec_int_free(&regular);
+	check(regular == NULL);
+
+	fprintf(stderr, "OK\n");
+}
+
+void check_gather(size_t vector_size) {
+	fprintf(stderr, "%s(%lu): ", __func__, vector_size);
+
+	// Create vectors of 4-byte and 8-byte elements and a random permutation of their indices
+	int *ints = NULL;
+	uint64_t *u64s = NULL;
+	size_t *perm = cvec_size_t_new(vector_size);
+	for (size_t i = 0; i < vector_size; i++) {
+		cvec_int_push_back(&ints, i);
+		cvec_uint64_t_push_back(&u64s, i << 32 | i);
+		cvec_size_t_push_back(&perm, i);
+	}
+	for (size_t i = vector_size - 1; i > 0; i--) {
+		size_t j = rand() % (i + 1), tmp = perm[i];
+		perm[i] = perm[j];
+		perm[j] = tmp;
+	}
+
+	// Gather by the permutation, scatter back by it
+	int *gathered = malloc(vector_size * sizeof(*gathered));
+	uint64_t *gathered64 = malloc(vector_size * sizeof(*gathered64));
+	cvec_int_gather(gathered, &ints, perm, vector_size);
+	cvec_uint64_t_gather(gathered64, &u64s, perm, vector_size);
+	for (size_t i = 0; i < vector_size; i++) {
+		check(gathered[i] == perm[i]);
+		check(gathered64[i] == (perm[i] << 32 | perm[i]));
+	}
+	cvec_int_clear(&ints);
+	cvec_int_resize(&ints, vector_size);
+	cvec_int_scatter(&ints, gathered, perm, vector_size);
+	for (size_t i = 0; i < vector_size; i++) {
+		check(ints[i] == i);
+	}
+
+	// Permute out of place and in place, the permutation should stay the same
+	cvec_int_permute(&ints, perm);
+	cvec_uint64_t_apply_permutation(&u64s, perm);
+	for (size_t i = 0; i < vector_size; i++) {
+		check(ints[i] == perm[i]);
+		check(u64s[i] == (perm[i] << 32 | perm[i]));
+	}
+
+	free(gathered);
+	free(gathered64);
+	cvec_int_free(&ints);
+	cvec_uint64_t_free(&u64s);
+	cvec_size_t_free(&perm);
+
+	fprintf(stderr, "OK\n");
+}
+
+void check_str(size_t count) {
+	fprintf(stderr, "%s(%lu): ", __func__, count);
+
+	// An empty string is terminated too
+	char *str = NULL;
+	check(strcmp(cvec_str_c_str(&str), "") == 0);
+
+	// Build a comma-separated list
+	for (int i = 0; i < count; i++) {
+		if (i % 2) {
+			cvec_str_appendf(&str, "%d,", i);
+		} else {
+			cvec_str_append_str(&str, "x");
+			cvec_str_append_mem(&str, "yz,", 3);
+		}
+	}
+	const char *c_str = cvec_str_c_str(&str);
+	check(strlen(c_str) == cvec_char_size(&str));
+	check(strncmp(c_str, "xyz,1,xyz,3,", 12) == 0);
+
+	// Long formatted output grows the string once
+	char long_arg[1000];
+	memset(long_arg, 'a', sizeof(long_arg) - 1);
+	long_arg[sizeof(long_arg) - 1] = '\0';
+	size_t size = cvec_char_size(&str);
+	check(cvec_str_appendf(&str, "[%s]", long_arg) == sizeof(long_arg) + 1);
+	check(cvec_char_size(&str) == size + sizeof(long_arg) + 1);
+	check(str[size] == '[' && str[size + 1] == 'a' && cvec_char_back(&str) == ']');
+
+	// Find
+	check(cvec_str_find(&str, "xyz", 0) == 0);
+	check(cvec_str_find(&str, "xyz", 1) == 6);
+	check(cvec_str_find(&str, "1,x", 0) == 4);
+	check(cvec_str_find(&str, "xyz,1,", 1) == CVEC_STR_NPOS);
+	check(cvec_str_find(&str, "]", 0) == cvec_char_size(&str) - 1);
+	check(cvec_str_find(&str, "", 5) == 5);
+	check(cvec_str_find_char(&str, ',', 0) == 3);
+	check(cvec_str_find_char(&str, '?', 0) == CVEC_STR_NPOS);
+
+	// Split, the last field holds the long output
+	size_t *fields = NULL;
+	check(cvec_str_split(&str, ',', &fields) == count + 1);
+	check(fields[0] == 0 && fields[1] == 3);
+	check(fields[2] == 4 && fields[3] == 1);
+	check(fields[2 * count + 1] == sizeof(long_arg) + 1);
+
+	cvec_char_free(&str);
+	cvec_size_t_free(&fields);
+
+	fprintf(stderr, "OK\n");
+}
+
+void check_numa(size_t vector_size) {
+	fprintf(stderr, "%s(%lu): ", __func__, vector_size);
+
+	// Policies may be unsupported, but the vectors should work anyway
+	for (int policy = CVEC_NUMA_DEFAULT; policy <= CVEC_NUMA_BIND; policy++) {
+		if (cvec_numa_set_policy(policy, 1) == 0) {
+			check(cvec_numa_policy() == policy);
+		}
+
+		// Fill by 3 threads, by one thread per CPU, by more threads than elements
+		numaint *ints = NULL;
+		cvec_numaint_resize_parallel(&ints, vector_size, 1, 3);
+		cvec_numaint_resize_parallel(&ints, vector_size * 2, 2, 0);
+		check(cvec_numaint_size(&ints) == vector_size * 2);
+		for (size_t i = 0; i < vector_size * 2; i++) {
+			check(ints[i] == (i < vector_size ? 1 : 2));
+		}
+		cvec_numaint_assign_fill_parallel(&ints, 5, 3, 64);
+		check(cvec_numaint_size(&ints) == 5);
+		for (size_t i = 0; i < 5; i++) {
+			check(ints[i] == 3);
+		}
+		cvec_numaint_assign_fill_parallel(&ints, vector_size * 4, 4, 2);
+		check(cvec_numaint_size(&ints) == vector_size * 4);
+		for (size_t i = 0; i < vector_size * 4; i++) {
+			check(ints[i] == 4);
+		}
+		cvec_numaint_resize_parallel(&ints, 0, 0, 2);
+		check(cvec_numaint_size(&ints) == 0);
+		cvec_numaint_free(&ints);
+
+		// Grow from the heap into a mapping of its own, grow the mapping and move back to the heap
+		for (size_t i = 0; i < vector_size * 4; i++) {
+			cvec_numaint_push_back(&ints, i);
+		}
+		cvec_numaint_resize(&ints, 10);
+		cvec_numaint_shrink_to_fit(&ints);
+		check(cvec_numaint_capacity(&ints) == 10);
+		for (size_t i = 0; i < 10; i++) {
+			check(ints[i] == (int)i);
+		}
+		cvec_numaint_free(&ints);
+	}
+
+	// A node which doesn't exist is rejected and the policy is left as is
+	check(cvec_numa_set_policy(CVEC_NUMA_DEFAULT, 0) == 0);
+	check(cvec_numa_set_policy(CVEC_NUMA_BIND, 1UL << 63) == -1);
+	check(cvec_numa_policy() == CVEC_NUMA_DEFAULT);
+
+	fprintf(stderr, "OK\n");
+}
+
 int main(int argc, char **argv) {
 	check_push_back(1000, 0);
 	check_push_back(1000, 500);
 	check_pop_back(1000);
 	check_pop_front(1000);
+	check_cow(1000);
+	check_shrink(1000);
+	check_incremental(1000);
+	check_delta(1000);
+	check_csr(1000);
+	check_cache(1000);
+	check_compact(1000);
+	check_gather(1000);
+	check_gather(1003);
+	check_str(1000);
+	check_numa(1000);
 }